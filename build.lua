@@ -103,6 +103,9 @@ precore.make_config_scoped("hord.projects", {
 		files {
 			"src/Hord/**.cpp",
 		}
+
+	configuration {"linux"}
+		links {"pthread"}
 end}})
 
 precore.apply_global({
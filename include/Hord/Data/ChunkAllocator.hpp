@@ -0,0 +1,183 @@
+/**
+@copyright MIT license; see @ref index or the accompanying LICENSE file.
+
+@file
+@brief Table chunk allocators.
+@ingroup data
+*/
+
+#pragma once
+
+#include <Hord/config.hpp>
+#include <Hord/aux.hpp>
+
+#include <cstdint>
+#include <mutex>
+
+namespace Hord {
+namespace Data {
+
+// Forward declarations
+class ChunkAllocator;
+class ChunkPool;
+
+/**
+	@addtogroup data
+	@{
+*/
+
+/**
+	Base table chunk allocator.
+
+	@note allocate() and free() may be called concurrently when a
+	table rewrites its records in parallel.
+*/
+class ChunkAllocator {
+protected:
+/** @name Implementation */ /// @{
+	/**
+		allocate() implementation.
+	*/
+	virtual std::uint8_t*
+	allocate_impl(
+		unsigned& size
+	) = 0;
+
+	/**
+		free() implementation.
+	*/
+	virtual void
+	free_impl(
+		std::uint8_t* data,
+		unsigned size
+	) noexcept = 0;
+/// @}
+
+public:
+/** @name Special member functions */ /// @{
+	/** Destructor. */
+	virtual
+	~ChunkAllocator() = 0;
+
+	/** Default constructor. */
+	ChunkAllocator() = default;
+	/** Copy constructor (deleted). */
+	ChunkAllocator(ChunkAllocator const&) = delete;
+	/** Copy assignment operator (deleted). */
+	ChunkAllocator& operator=(ChunkAllocator const&) = delete;
+	/** Move constructor (deleted). */
+	ChunkAllocator(ChunkAllocator&&) = delete;
+	/** Move assignment operator (deleted). */
+	ChunkAllocator& operator=(ChunkAllocator&&) = delete;
+/// @}
+
+/** @name Operations */ /// @{
+	/**
+		Get the default allocator.
+
+		@note This is a ChunkPool shared by every table that does
+		not have an allocator assigned.
+	*/
+	static Data::ChunkAllocator&
+	default_allocator() noexcept;
+
+	/**
+		Allocate chunk data.
+
+		@param[in,out] size Minimum size of the chunk data; assigned
+		the size of the allocated data.
+	*/
+	std::uint8_t*
+	allocate(
+		unsigned& size
+	) {
+		return allocate_impl(size);
+	}
+
+	/**
+		Free chunk data.
+
+		@param data Data from allocate().
+		@param size Size assigned by allocate().
+	*/
+	void
+	free(
+		std::uint8_t* const data,
+		unsigned const size
+	) noexcept {
+		free_impl(data, size);
+	}
+/// @}
+};
+
+/**
+	Pooled chunk allocator.
+
+	Sizes are rounded up to a multiple of @c GRANULARITY. Freed data
+	in the first @c NUM_CLASSES size classes is retained for reuse.
+
+	@note This is thread-safe.
+*/
+class ChunkPool final
+	: public Data::ChunkAllocator
+{
+public:
+	enum : unsigned {
+		/** Size class granularity. */
+		GRANULARITY = 0x2000,
+		/** Number of pooled size classes. */
+		NUM_CLASSES = 8,
+	};
+
+private:
+	std::mutex m_mutex{};
+	unsigned m_class_limit;
+	aux::vector<std::uint8_t*> m_classes[NUM_CLASSES]{};
+
+	std::uint8_t*
+	allocate_impl(
+		unsigned& size
+	) override;
+
+	void
+	free_impl(
+		std::uint8_t* data,
+		unsigned size
+	) noexcept override;
+
+public:
+/** @name Special member functions */ /// @{
+	/** Destructor. */
+	~ChunkPool() noexcept override;
+
+	/**
+		Constructor with retention limit.
+
+		@param class_limit Maximum number of retained chunks per size
+		class.
+	*/
+	explicit
+	ChunkPool(
+		unsigned const class_limit = 0x40
+	);
+/// @}
+
+/** @name Operations */ /// @{
+	/**
+		Free all retained data.
+	*/
+	void
+	release() noexcept;
+
+	/**
+		Get the number of retained chunks.
+	*/
+	unsigned
+	num_retained() noexcept;
+/// @}
+};
+
+/** @} */ // end of doc-group data
+
+} // namespace Data
+} // namespace Hord
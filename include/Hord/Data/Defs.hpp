@@ -72,6 +72,25 @@ enum class ValueFlag : Data::TypeValue {
 
 	/** Make ValueType::integer signed. */
 	integer_signed = 1 << 0,
+
+	/**
+		Store ValueType::string as a code into a dictionary of
+		distinct values.
+
+		@note This only has effect on table columns. Codes have the
+		size of the string's size meta data.
+	*/
+	string_dictionary = 1 << 1,
+
+	/**
+		Store fields sparsely.
+
+		@note This only has effect on table columns. Fields with
+		their initial value (zero, empty, or null) take no space in
+		records. Other fields are located by decoding the sparse
+		fields before them.
+	*/
+	field_sparse = 1 << 2,
 };
 
 /**
@@ -397,6 +416,9 @@ s_type_properties[]{
 
 	// string
 	{VTP_DYNAMIC_SIZE, {0}},
+
+	// string (dictionary-coded)
+	{VTP_NONE, {1, 2, 4, 4}},
 };
 } // anonymous namespace
 
@@ -412,12 +434,20 @@ type_properties(
 
 /**
 	Get value type properties for a type.
+
+	@note Dictionary-coded strings have the properties of their
+	codes.
 */
 inline constexpr Data::ValueTypeProperties const&
 type_properties(
 	Data::Type const type
 ) noexcept {
-	return Data::type_properties(type.type());
+	return
+		type.type() == Data::ValueType::string &&
+		(enum_cast(type.flags()) & enum_cast(Data::ValueFlag::string_dictionary))
+		? Data::s_type_properties[enum_cast(Data::value_type_last) + 1]
+		: Data::type_properties(type.type())
+	;
 }
 
 /**
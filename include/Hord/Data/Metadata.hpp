@@ -61,7 +61,9 @@ public:
 	~Metadata() noexcept = default;
 
 	/** Default constructor. */
-	Metadata() = default;
+	Metadata() noexcept {
+		m_table.set_index_column(COL_NAME);
+	}
 	/** Move constructor. */
 	Metadata(Metadata&&) = default;
 	/** Move assignment operator. */
@@ -16,9 +16,14 @@
 #include <Hord/Data/Defs.hpp>
 #include <Hord/Data/ValueRef.hpp>
 #include <Hord/Data/TableSchema.hpp>
+#include <Hord/Data/ChunkAllocator.hpp>
 
 #include <duct/debug.hpp>
 
+#include <atomic>
+#include <iosfwd>
+#include <utility>
+
 namespace Hord {
 namespace Data {
 
@@ -35,12 +40,234 @@ class Table;
 */
 class Table {
 public:
+	/**
+		Record layout.
+	*/
+	enum class Layout : std::uint8_t {
+		/**
+			Fields are stored in column order.
+
+			Fields after the first variably-sized field are located
+			by decoding every field before them.
+		*/
+		sequential = 0,
+
+		/**
+			Fixed-size fields are stored first at constant offsets.
+
+			Variably-sized fields (strings and dynamic values) follow
+			in column order. All but the first are located through an
+			offset array in the record header, so any field is
+			addressable directly.
+		*/
+		indexed = 1,
+
+		/**
+			Fields are stored column-major within each chunk.
+
+			Each chunk holds one fixed-width array per column, so
+			scanning a column touches only that column's values.
+
+			@note This only applies to schemas with fixed-size
+			columns and no sparse columns. Other schemas are stored
+			as @c Layout::sequential.
+		*/
+		columnar = 2,
+	};
+
+	/*
+		NB: If a schema has only fixed-size columns (none of them
+		sparse), every record has the same size. The row layouts then
+		store records without a header at a fixed stride.
+	*/
+
+	/** @cond INTERNAL */
+	struct RecordFormat {
+		Data::Table::Layout layout{Data::Table::Layout::sequential};
+		/** Whether record sizes are varints. */
+		bool compact{false};
+		/** Size of the offset array in record headers (indexed). */
+		unsigned slots_size{0};
+		/** Record size if every record is the same size (headerless). */
+		unsigned stride{0};
+		/** Whether chunks are column-major (requires stride). */
+		bool columnar{false};
+		/** Size of the fields with constant offsets. */
+		unsigned fixed_size{0};
+		/** First column located by decoding (sequential). */
+		unsigned walk_column{0};
+		/** Constant field offsets (~0u if not constant). */
+		aux::vector<unsigned> field_offsets{};
+		/** Offset array slot by column (~0u if not slotted). */
+		aux::vector<unsigned> field_slots{};
+		/** Variably-sized columns in storage order (indexed). */
+		aux::vector<unsigned> slot_columns{};
+		/** Presence bit by column (~0u if not sparse). */
+		aux::vector<unsigned> sparse_bits{};
+		/** Sparse columns in storage order. */
+		aux::vector<unsigned> sparse_columns{};
+		/** Initial field size by column. */
+		aux::vector<unsigned> init_sizes{};
+	};
+
+	/**
+		Format of chunks written before an instant schema change.
+	*/
+	struct SchemaVersion {
+		unsigned version;
+		/** Schema the chunks were written with. */
+		Data::TableSchema schema;
+		RecordFormat format;
+		/**
+			Current columns, with @c index as the column in
+			@c schema (~0u if added since).
+		*/
+		Data::TableSchema::column_vector_type columns;
+	};
+
+	/**
+		Column value index.
+	*/
+	struct HashIndex {
+		/** Indexed column (~0u if none). */
+		unsigned column{~0u};
+		/** Record IDs by value hash. */
+		aux::unordered_multimap<HashValue, unsigned> records{};
+	};
+
+	/**
+		Ordered column value index.
+	*/
+	struct OrderedIndex {
+		/** Indexed column (~0u if none). */
+		unsigned column{~0u};
+		/** Record IDs by value order key. */
+		aux::multimap<std::uint64_t, unsigned> records{};
+	};
+
+	/**
+		Stable record IDs in record order.
+
+		Index entries refer to records by ID, so inserting or
+		removing a record does not renumber the entries of other
+		records. IDs are positioned by an order-statistic tree (a
+		treap with priorities hashed from IDs).
+	*/
+	struct RecordIds {
+		/** Tree node. */
+		struct Node {
+			/** Parent ID (~0u if root). */
+			unsigned parent;
+			/** Left child ID (~0u if none). */
+			unsigned left;
+			/** Right child ID (~0u if none). */
+			unsigned right;
+			/** Number of records in the subtree. */
+			unsigned size;
+		};
+
+		/** Nodes by ID. */
+		aux::vector<Node> nodes{};
+		/** Unused IDs. */
+		aux::vector<unsigned> free{};
+		/** Root ID (~0u if empty). */
+		unsigned root{~0u};
+	};
+
+	/**
+		Distinct values of a dictionary-coded string column.
+	*/
+	struct Dictionary {
+		/** Values by code (code 0 is the empty string). */
+		aux::deque<String> values{};
+		/** Codes by value hash. */
+		aux::unordered_multimap<HashValue, unsigned> codes{};
+	};
+	/** @endcond */ // INTERNAL
+
+	/**
+		Column value bounds of a chunk (zone map).
+
+		Integer, decimal and object ID columns are bounded by
+		value order key; string columns (except dictionary-coded
+		columns) by length. Other columns are unbounded.
+
+		@note A zone with @c min greater than @c max has no values.
+	*/
+	struct Zone {
+		std::uint64_t min{~std::uint64_t{0}};
+		std::uint64_t max{0};
+	};
+
+	/**
+		Column value set of a chunk (Bloom filter).
+
+		String (except dictionary-coded) and object ID columns can
+		have filters.
+
+		@note A filter without bits is absent.
+	*/
+	struct Bloom {
+		/** Number of values added since the filter was built. */
+		unsigned num_values{0};
+		aux::vector<std::uint64_t> bits{};
+	};
+
 	struct Chunk {
+		/** Allocator of data (default allocator if null). */
+		Data::ChunkAllocator* allocator{nullptr};
 		std::uint8_t* data{nullptr};
 		std::uint8_t* head{nullptr};
 		std::uint8_t* tail{nullptr};
 		unsigned size{0};
 		unsigned num_records{0};
+		/** Whether records may have slack (compaction candidate). */
+		bool dirty{false};
+		/**
+			Owner count of data (null if no data).
+
+			Data is shared between tables by assign() and copied
+			when a sharing table modifies it. The count is
+			allocated with the data.
+		*/
+		std::atomic<unsigned>* refs{nullptr};
+		/**
+			Whether data is borrowed from read_mapped().
+
+			Borrowed data is never freed and is copied when the
+			chunk is modified, as if it were shared.
+		*/
+		bool borrowed{false};
+		/** Schema version the records were written with. */
+		unsigned version{0};
+		/**
+			Sparse record offset directory.
+
+			Offset of every @c Table::CHUNK_MARK_STRIDE-th record,
+			built lazily when seeking and cleared when the chunk is
+			modified.
+		*/
+		aux::vector<unsigned> marks{};
+		/**
+			Column value bounds by column of the chunk's schema
+			version (unknown if empty).
+
+			Bounds widen as records are added or modified and are
+			rebuilt by compaction, so they may be loose but never
+			exclude a value in the chunk. Filters skip chunks
+			whose bounds rule out a match.
+		*/
+		aux::vector<Data::Table::Zone> zones{};
+		/**
+			Column value filters by column of the chunk's schema
+			version (none if empty).
+
+			Filters are built by compaction for the table's filtered
+			columns and take values as records are added or
+			modified. Equality filters skip chunks whose filters
+			rule out the value.
+		*/
+		aux::vector<Data::Table::Bloom> blooms{};
 
 		unsigned
 		offset_head() const noexcept {
@@ -71,6 +298,523 @@ public:
 		}
 	};
 
+	/** @cond INTERNAL */
+	/**
+		Chunk sequence.
+
+		This is a balanced binary tree ordered by chunk position.
+		Each node carries the number of chunks and records in its
+		subtree, so positional access, insertion, removal and
+		record seeking are logarithmic in the number of chunks.
+
+		@note Chunk data is not owned. The counts of a chunk
+		modified in place must be refreshed with recount().
+	*/
+	class ChunkTree final {
+	public:
+		struct Node {
+			Chunk chunk;
+			Node* parent;
+			Node* left;
+			Node* right;
+			unsigned height;
+			unsigned num_chunks;
+			unsigned num_records;
+		};
+
+		template<class N, class C>
+		struct basic_iterator {
+			N* node;
+
+			C&
+			operator*() const noexcept {
+				return node->chunk;
+			}
+
+			C*
+			operator->() const noexcept {
+				return &node->chunk;
+			}
+
+			basic_iterator&
+			operator++() noexcept {
+				node = ChunkTree::next(node);
+				return *this;
+			}
+
+			bool
+			operator==(
+				basic_iterator const& rhs
+			) const noexcept {
+				return node == rhs.node;
+			}
+
+			bool
+			operator!=(
+				basic_iterator const& rhs
+			) const noexcept {
+				return node != rhs.node;
+			}
+		};
+
+		using iterator = basic_iterator<Node, Chunk>;
+		using const_iterator = basic_iterator<Node const, Chunk const>;
+
+		/**
+			Chunk access hint.
+
+			Held by the accessor rather than the tree so that
+			concurrent readers do not share it. A hint is valid
+			until chunks are inserted or erased.
+
+			@sa at()
+		*/
+		struct Hint {
+			Node const* node;
+			unsigned index;
+			unsigned generation;
+		};
+
+	private:
+		Node* m_root{nullptr};
+		/** Incremented when chunks are inserted or erased. */
+		unsigned m_generation{0};
+
+		static Node*
+		first(
+			Node* node
+		) noexcept;
+
+		static Node*
+		last(
+			Node* node
+		) noexcept;
+
+		template<class N>
+		static N*
+		next(
+			N* node
+		) noexcept {
+			return const_cast<N*>(ChunkTree::next_node(node));
+		}
+
+		static Node const*
+		next_node(
+			Node const* node
+		) noexcept;
+
+		Node*
+		select(
+			unsigned index
+		) const noexcept;
+
+		void
+		rebalance_from(
+			Node* node
+		) noexcept;
+
+		void
+		destroy(
+			Node* node
+		) noexcept;
+
+	public:
+		~ChunkTree() noexcept {
+			clear();
+		}
+
+		ChunkTree() = default;
+		ChunkTree(ChunkTree const&) = delete;
+		ChunkTree& operator=(ChunkTree const&) = delete;
+
+		ChunkTree(
+			ChunkTree&& other
+		) noexcept {
+			swap(other);
+		}
+
+		ChunkTree&
+		operator=(
+			ChunkTree&& other
+		) noexcept {
+			swap(other);
+			return *this;
+		}
+
+		/** Get number of chunks. */
+		unsigned
+		size() const noexcept {
+			return m_root ? m_root->num_chunks : 0;
+		}
+
+		/** Check if there are no chunks. */
+		bool
+		empty() const noexcept {
+			return !m_root;
+		}
+
+		/** Get number of records in all chunks. */
+		unsigned
+		num_records() const noexcept {
+			return m_root ? m_root->num_records : 0;
+		}
+
+		Chunk&
+		operator[](
+			unsigned const index
+		) noexcept {
+			return select(index)->chunk;
+		}
+
+		Chunk const&
+		operator[](
+			unsigned const index
+		) const noexcept {
+			return select(index)->chunk;
+		}
+
+		Chunk&
+		front() noexcept {
+			return first(m_root)->chunk;
+		}
+
+		Chunk const&
+		front() const noexcept {
+			return first(m_root)->chunk;
+		}
+
+		Chunk&
+		back() noexcept {
+			return last(m_root)->chunk;
+		}
+
+		Chunk const&
+		back() const noexcept {
+			return last(m_root)->chunk;
+		}
+
+		/**
+			Get the chunk at @a index through a hint.
+
+			@note Repeated and sequential access through the same
+			hint is constant.
+		*/
+		Chunk const&
+		at(
+			unsigned const index,
+			Hint& hint
+		) const noexcept {
+			if (hint.node && hint.generation == m_generation) {
+				if (index == hint.index) {
+					return hint.node->chunk;
+				} else if (index == hint.index + 1) {
+					hint.node = next(hint.node);
+					hint.index = index;
+					return hint.node->chunk;
+				}
+			}
+			hint = {select(index), index, m_generation};
+			return hint.node->chunk;
+		}
+
+		/**
+			Get the chunk at @a index through a hint.
+		*/
+		Chunk&
+		at(
+			unsigned const index,
+			Hint& hint
+		) noexcept {
+			return const_cast<Chunk&>(
+				static_cast<ChunkTree const*>(this)->at(index, hint)
+			);
+		}
+
+		iterator
+		begin() noexcept {
+			return {m_root ? first(m_root) : nullptr};
+		}
+
+		iterator
+		end() noexcept {
+			return {nullptr};
+		}
+
+		const_iterator
+		begin() const noexcept {
+			return {m_root ? first(m_root) : nullptr};
+		}
+
+		const_iterator
+		end() const noexcept {
+			return {nullptr};
+		}
+
+		/**
+			Find the chunk containing a record.
+
+			@param index Record index (must be in bounds).
+			@param[out] first_index Index of the chunk's first
+			record.
+
+			@returns Index of the chunk.
+		*/
+		unsigned
+		find(
+			unsigned index,
+			unsigned& first_index
+		) const noexcept;
+
+		/**
+			Get the index of the first record in a chunk.
+		*/
+		unsigned
+		first_index(
+			unsigned index
+		) const noexcept;
+
+		/**
+			Insert a chunk before the chunk at @a index.
+		*/
+		void
+		insert(
+			unsigned index,
+			Chunk const& chunk
+		);
+
+		/**
+			Insert a chunk at the end.
+		*/
+		void
+		push_back(
+			Chunk const& chunk
+		) {
+			insert(size(), chunk);
+		}
+
+		/**
+			Remove the chunk at @a index.
+		*/
+		void
+		erase(
+			unsigned index
+		) noexcept;
+
+		/**
+			Remove chunks after the first @a count.
+		*/
+		void
+		truncate(
+			unsigned const count
+		) noexcept {
+			while (count < size()) {
+				erase(size() - 1);
+			}
+		}
+
+		/**
+			Refresh the counts of the chunk at @a index.
+		*/
+		void
+		recount(
+			unsigned index
+		) noexcept;
+
+		/**
+			Refresh the counts of every chunk.
+		*/
+		void
+		recount() noexcept;
+
+		/**
+			Remove all chunks.
+		*/
+		void
+		clear() noexcept {
+			destroy(m_root);
+			m_root = nullptr;
+			++m_generation;
+		}
+
+		void
+		swap(
+			ChunkTree& other
+		) noexcept {
+			std::swap(m_root, other.m_root);
+			// NB: Hints of either tree must not match the other
+			m_generation = max_ce(m_generation, other.m_generation) + 1;
+			other.m_generation = m_generation;
+		}
+	};
+	/** @endcond */ // INTERNAL
+
+	/**
+		Column aggregate.
+
+		@sa aggregate()
+	*/
+	struct Aggregate {
+		/** Number of values. */
+		unsigned count{0};
+		/**
+			Sum of values.
+
+			@note This is a 64-bit integer with the column's
+			signedness for integer columns and a 64-bit decimal for
+			decimal columns.
+		*/
+		Data::ValueRef sum{};
+		/** Smallest value (column type). */
+		Data::ValueRef min{};
+		/** Largest value (column type). */
+		Data::ValueRef max{};
+
+		/**
+			Get mean value.
+
+			@returns @c 0.0 if there are no values.
+		*/
+		double
+		mean() const noexcept {
+			if (count == 0) {
+				return 0.0;
+			} else if (sum.type.type() == Data::ValueType::decimal) {
+				return sum.decimal() / count;
+			} else if (enum_cast(sum.type.flags() & Data::ValueFlag::integer_signed)) {
+				return static_cast<double>(sum.integer_signed()) / count;
+			} else {
+				return static_cast<double>(sum.integer_unsigned()) / count;
+			}
+		}
+	};
+
+	/**
+		Sort order.
+	*/
+	enum class Order : unsigned {
+		ascending = 0,
+		descending,
+	};
+
+	/**
+		Filter comparison.
+	*/
+	enum class Compare : unsigned {
+		equal = 0,
+		not_equal,
+		less,
+		less_equal,
+		greater,
+		greater_equal,
+	};
+
+	/**
+		Record filter.
+
+		@sa select()
+	*/
+	struct Filter {
+		/**
+			Filter term (<code>field op value</code>).
+
+			@note Integer values are compared exactly against
+			integer columns. Other values are morphed to the column
+			type. Dynamic columns only support equality.
+		*/
+		struct Term {
+			/** Column index. */
+			unsigned column;
+			/** Comparison. */
+			Data::Table::Compare compare;
+			/** Value to compare with. */
+			Data::ValueRef value;
+		};
+
+		/** Whether any term (OR) or every term (AND) must match. */
+		bool match_any{false};
+		/** Terms. */
+		aux::vector<Term> terms{};
+	};
+
+	/**
+		Record selection bitmap.
+
+		@note Selections from the same table can be combined with
+		bitwise operators to compose filters.
+	*/
+	struct Selection {
+		/** Number of records. */
+		unsigned num_records{0};
+		/** Bits by record index. */
+		aux::vector<std::uint64_t> bits{};
+
+		/**
+			Reset to @a num_records records with all bits set to
+			@a value.
+		*/
+		void
+		reset(
+			unsigned const num_records,
+			bool const value
+		) {
+			this->num_records = num_records;
+			bits.assign((num_records + 63) / 64, value ? ~std::uint64_t{0} : 0);
+			if (value && (num_records & 63)) {
+				bits.back() = ~(~std::uint64_t{0} << (num_records & 63));
+			}
+		}
+
+		/**
+			Check if a record is selected.
+		*/
+		bool
+		test(
+			unsigned const index
+		) const noexcept {
+			return (bits[index >> 6] >> (index & 63)) & 1;
+		}
+
+		/**
+			Count selected records.
+		*/
+		unsigned
+		count() const noexcept;
+
+		/**
+			Get the indices of selected records.
+		*/
+		void
+		indices(
+			aux::vector<unsigned>& indices
+		) const;
+
+		/**
+			Intersect with another selection.
+		*/
+		Selection&
+		operator&=(
+			Selection const& other
+		) noexcept {
+			for (unsigned index = 0; index < bits.size(); ++index) {
+				bits[index] &= other.bits[index];
+			}
+			return *this;
+		}
+
+		/**
+			Unite with another selection.
+		*/
+		Selection&
+		operator|=(
+			Selection const& other
+		) noexcept {
+			for (unsigned index = 0; index < bits.size(); ++index) {
+				bits[index] |= other.bits[index];
+			}
+			return *this;
+		}
+	};
+
 	friend struct Iterator;
 	struct Iterator {
 		Data::Table* table;
@@ -78,6 +822,10 @@ public:
 		unsigned chunk_index;
 		unsigned inner_index;
 		unsigned data_offset;
+		/** @cond INTERNAL */
+		/** Chunk access hint (unset if null). */
+		mutable ChunkTree::Hint chunk_hint;
+		/** @endcond */
 
 		bool
 		operator==(
@@ -108,6 +856,9 @@ public:
 
 		/**
 			Advance by count.
+
+			@note This seeks through the chunk index if @a count is
+			not local to the current chunk.
 		*/
 		Iterator&
 		operator+=(
@@ -131,7 +882,7 @@ public:
 		insert(
 			unsigned const num_fields,
 			Data::ValueRef* const fields
-		) noexcept {
+		) {
 			table->insert(*this, num_fields, fields);
 		}
 
@@ -166,20 +917,161 @@ public:
 	};
 
 	/**
-		Chunk vector type.
+		Record cursor.
+
+		Reads several fields of each record, locating them in one
+		pass over the record rather than once per field.
+
+		@sa cursor()
+	*/
+	struct Cursor {
+		/** Current record. */
+		Data::Table::Iterator it;
+		/**
+			Whether each column is read.
+
+			Columns past the end of the mask are not read, so
+			fields after the last masked column are never decoded.
+		*/
+		aux::vector<bool> mask{};
+		/**
+			Field values of the current record by column.
+
+			@note Unread columns have null values.
+		*/
+		aux::vector<Data::ValueRef> values{};
+		/** @cond INTERNAL */
+		/** Field offsets of the current record (scratch). */
+		aux::vector<unsigned> offsets{};
+		/** @endcond */
+
+		/**
+			Whether the cursor is at a record.
+		*/
+		bool
+		valid() const noexcept {
+			return it.can_advance();
+		}
+
+		/**
+			Read the fields of the current record.
+		*/
+		void
+		read() {
+			it.table->get_fields(*this);
+		}
+
+		/**
+			Advance and read the fields of the next record.
+		*/
+		Cursor&
+		operator++() {
+			++it;
+			read();
+			return *this;
+		}
+	};
+
+	/**
+		Chunk sequence type.
 	*/
-	using chunk_vector_type = aux::vector<Chunk>;
+	using chunk_tree_type = ChunkTree;
+
+	/**
+		Schema version vector type.
+	*/
+	using version_vector_type = aux::vector<SchemaVersion>;
+
+	/**
+		Column dictionary vector type.
+
+		@note This is empty if no column is dictionary-coded.
+	*/
+	using dictionary_vector_type = aux::vector<Dictionary>;
+
+	enum : unsigned {
+		/**
+			Number of records between entries in a chunk's sparse
+			record offset directory.
+		*/
+		CHUNK_MARK_STRIDE = 0x20,
+
+		/** Number of Bloom filter bits per value of a chunk. */
+		BLOOM_BITS_PER_VALUE = 10,
+
+		/** Number of Bloom filter bits set per value. */
+		BLOOM_NUM_HASHES = 7,
+	};
 
 private:
 	unsigned m_num_records{0};
 	Data::TableSchema m_schema{};
-	chunk_vector_type m_chunks{};
+	RecordFormat m_format{};
+	chunk_tree_type m_chunks{};
+	Data::ChunkAllocator* m_allocator{nullptr};
+	unsigned m_version{0};
+	version_vector_type m_versions{};
+	HashIndex m_index{};
+	OrderedIndex m_ordered_index{};
+	RecordIds m_record_ids{};
+	dictionary_vector_type m_dictionaries{};
+	aux::vector<unsigned> m_bloom_columns{};
 
 	Table(Table const&) = delete;
 	Table& operator=(Table const&) = delete;
 
 private:
+	Chunk
+	make_chunk() const noexcept {
+		Chunk chunk{};
+		chunk.allocator = m_allocator;
+		chunk.version = m_version;
+		return chunk;
+	}
+
 	void free_chunks();
+	void recount_chunks(unsigned from, unsigned count) noexcept;
+	unsigned upgrade_chunk(unsigned index) noexcept;
+	void upgrade_chunk(Iterator& it) noexcept;
+	void upgrade_chunks() noexcept;
+	void index_add(unsigned index) noexcept;
+	void index_append(unsigned first, unsigned count) noexcept;
+	void index_remove(unsigned index) noexcept;
+	void index_remove(Data::Table::Selection const& selection) noexcept;
+	void index_permute(aux::vector<unsigned> const& permutation) noexcept;
+	void index_rebuild() noexcept;
+	Data::ValueRef encode_value(
+		unsigned column_index,
+		Data::ValueRef value
+	);
+	Data::ValueRef* encode_fields(
+		unsigned num_records,
+		unsigned num_fields,
+		unsigned fields_stride,
+		Data::ValueRef* fields,
+		aux::vector<Data::ValueRef>& encoded
+	);
+	void migrate(
+		RecordFormat const& format,
+		Data::TableSchema::column_vector_type const& columns,
+		dictionary_vector_type const& dictionaries
+	);
+	void read_impl(
+		InputSerializer& ser,
+		std::streambuf* mapped_buffer,
+		std::uint8_t const* mapped_data
+	);
+	void insert_columns(
+		Iterator& it,
+		unsigned num_fields,
+		Data::ValueRef const* fields
+	) noexcept;
+	void append_columns(
+		unsigned num_records,
+		unsigned num_fields,
+		unsigned fields_stride,
+		Data::ValueRef const* fields
+	) noexcept;
 
 public:
 /** @name Special member functions */ /// @{
@@ -249,6 +1141,77 @@ public:
 	any() const noexcept {
 		return 0 < num_records();
 	}
+
+	/**
+		Get record layout.
+	*/
+	Data::Table::Layout
+	layout() const noexcept {
+		return m_format.layout;
+	}
+
+	/**
+		Check if chunks are stored column-major.
+
+		@sa Layout::columnar
+	*/
+	bool
+	columnar() const noexcept {
+		return m_format.columnar;
+	}
+
+	/**
+		Get record stride.
+
+		@note This is selected automatically when the schema changes.
+
+		@returns The size of every record if the schema has only
+		fixed-size columns (records are stored without a header),
+		or @c 0 otherwise.
+	*/
+	unsigned
+	record_stride() const noexcept {
+		return m_format.stride;
+	}
+
+	/**
+		Check if record headers are compact.
+
+		@sa set_compact_headers()
+	*/
+	bool
+	compact_headers() const noexcept {
+		return m_format.compact;
+	}
+
+	/**
+		Get chunk allocator.
+
+		@returns The assigned allocator, or @c nullptr if the table
+		uses the default allocator.
+	*/
+	Data::ChunkAllocator*
+	allocator() const noexcept {
+		return m_allocator;
+	}
+
+	/**
+		Set chunk allocator.
+
+		@note Existing chunks are freed by the allocator that
+		allocated them; new chunks come from @a allocator.
+
+		@warning @a allocator must outlive every chunk it allocates.
+
+		@param allocator Allocator, or @c nullptr to use
+		Data::ChunkAllocator::default_allocator().
+	*/
+	void
+	set_allocator(
+		Data::ChunkAllocator* const allocator
+	) noexcept {
+		m_allocator = allocator;
+	}
 /// @}
 
 /** @name Layout */ /// @{
@@ -269,6 +1232,14 @@ public:
 		@c index is the column to modify. When inserting a column,
 		@c index must be @c ~0u.
 
+		@note Dropping columns and appending columns are instant
+		when the remaining columns keep their order and types.
+		Existing chunks are then decoded through their schema version
+		and are rewritten when modified or compacted.
+
+		@note If records are rewritten, large tables are rewritten in
+		parallel, with chunks partitioned between worker threads.
+
 		@par
 		@warning The new schema's hash must be accurate before this
 		is used.
@@ -283,6 +1254,10 @@ public:
 
 		@throws Error{ErrorCode::table_column_name_shared}
 		If a column name is non-unique.
+
+		@throws Error{ErrorCode::table_dictionary_full}
+		If a column converted to dictionary coding has more distinct
+		values than codes.
 	*/
 	bool
 	configure(
@@ -303,6 +1278,37 @@ public:
 	replace_schema(
 		Data::TableSchema const& schema
 	);
+
+	/**
+		Set record layout.
+
+		@note Records are rewritten if the layout changed.
+
+		@returns @c true if the layout changed.
+	*/
+	bool
+	set_layout(
+		Data::Table::Layout const layout
+	);
+
+	/**
+		Set whether record headers are compact.
+
+		Compact headers store the size of a record as a LEB128 varint
+		rather than a 32-bit integer, so records shorter than 128
+		bytes have a 1-byte header. This favors tables of many short
+		records, at the cost of decoding the size when walking
+		records.
+
+		@note Records are rewritten if the setting changed. Records
+		stored at a fixed stride have no header and are unaffected.
+
+		@returns @c true if the setting changed.
+	*/
+	bool
+	set_compact_headers(
+		bool const compact
+	);
 /// @}
 
 /** @name Iteration */ /// @{
@@ -312,10 +1318,10 @@ public:
 	Data::Table::Iterator
 	begin() {
 		if (m_chunks.empty()) {
-			return {this, m_num_records, 0, 0, 0};
+			return {this, m_num_records, 0, 0, 0, {}};
 		} else {
 			auto const& chunk = m_chunks.front();
-			return {this, 0, 0, 0, chunk.offset_head()};
+			return {this, 0, 0, 0, chunk.offset_head(), {}};
 		}
 	}
 
@@ -325,7 +1331,7 @@ public:
 	Data::Table::Iterator
 	end() {
 		if (m_chunks.empty()) {
-			return {this, m_num_records, 0, 0, 0};
+			return {this, m_num_records, 0, 0, 0, {}};
 		} else {
 			auto const& chunk = m_chunks.back();
 			return {
@@ -333,34 +1339,71 @@ public:
 				m_num_records,
 				static_cast<unsigned>(m_chunks.size() - 1),
 				chunk.num_records,
-				chunk.offset_tail()
+				chunk.offset_tail(),
+				{}
 			};
 		}
 	}
 
 	/**
 		Get iterator at index.
+
+		@note This is logarithmic in the number of chunks. The
+		position within the chunk is found through the chunk's
+		sparse record offset directory.
+
+		@returns end() if @a index is out-of-bounds.
 	*/
 	Data::Table::Iterator
 	iterator_at(
 		unsigned const index
-	) {
-		auto it = begin();
-		it += min_ce(index, m_num_records);
-		return it;
-	}
+	);
+
+	/**
+		Get cursor at the first record.
+
+		@param mask Whether each column is read.
+		@sa Cursor
+	*/
+	Data::Table::Cursor
+	cursor(
+		aux::vector<bool> mask
+	);
 /// @}
 
 /** @name Modification */ /// @{
 	/**
 		Optimize record storage.
+
+		@note This rewrites every chunk, trimming slack from every
+		record and packing records into as few chunks as possible.
+
+		@sa compact_storage()
 	*/
 	void
 	optimize_storage();
 
+	/**
+		Compact fragmented chunks.
+
+		@note Only modified chunks whose record slack exceeds a
+		fraction of their used space are compacted, in place.
+		Unmodified chunks are untouched. This is done by write().
+		Zones and filters are rebuilt for compacted chunks and
+		chunks without them.
+
+		@sa optimize_storage()
+	*/
+	void
+	compact_storage() noexcept;
+
 	/**
 		Assign to a copy of another table.
 
+		@note Chunk data is shared with @a table and copied only when
+		either table modifies it. Shared chunks keep the allocator of
+		@a table.
+
 		@returns @c true if the schema changed.
 	*/
 	bool
@@ -376,14 +1419,20 @@ public:
 	/**
 		Insert a record.
 
-		@note Fields may be morphed to other types.
+		@note Fields may be morphed to other types. Values of
+		dictionary-coded columns are added to the column's dictionary
+		if they are not already in it.
+
+		@throws Error{ErrorCode::table_dictionary_full}
+		If a dictionary-coded column has no code left for a new value.
+		The table is not modified.
 	*/
 	void
 	insert(
 		Data::Table::Iterator& it,
 		unsigned num_fields,
 		Data::ValueRef* const fields
-	) noexcept;
+	);
 
 	/**
 		Push a record to the end of the table.
@@ -394,11 +1443,78 @@ public:
 	push_back(
 		unsigned num_fields,
 		Data::ValueRef* const fields
-	) noexcept {
+	) {
 		auto it = end();
 		insert(it, num_fields, fields);
 	}
 
+	/**
+		Push records to the end of the table.
+
+		@note This sizes every record up front and writes records
+		contiguously at the tail of the table.
+
+		@param num_records Number of records.
+		@param num_fields Number of fields per record.
+		@param fields Fields for each record
+		(<code>num_records * num_fields</code> values).
+
+		@sa insert()
+	*/
+	void
+	append_batch(
+		unsigned num_records,
+		unsigned num_fields,
+		Data::ValueRef* const fields
+	);
+
+	/**
+		Push produced records to the end of the table.
+
+		@par
+		@code
+		unsigned producer(unsigned index, Data::ValueRef* fields);
+		@endcode
+		@a producer fills @a fields (with room for
+		@c num_columns() values) for record @a index and returns the
+		number of fields supplied. Field data must remain valid until
+		the next call.
+
+		@note Produced records are buffered, copying string data, and
+		appended as one batch.
+
+		@sa append_batch(unsigned, unsigned, Data::ValueRef* const)
+	*/
+	template<class F>
+	void
+	append_batch(
+		unsigned const num_records,
+		F&& producer
+	) {
+		unsigned const num_fields = num_columns();
+		aux::vector<Data::ValueRef> fields(num_records * num_fields);
+		aux::deque<String> strings{};
+		unsigned num_produced;
+		for (unsigned index = 0; index < num_records; ++index) {
+			auto* const record = fields.data() + index * num_fields;
+			num_produced = min_ce(producer(index, record), num_fields);
+			for (unsigned column_index = 0; column_index < num_fields; ++column_index) {
+				auto& field = record[column_index];
+				if (column_index >= num_produced) {
+					// NB: Unsupplied fields take the initial value
+					field = {column(column_index).type};
+				} else if (
+					0 < field.size &&
+					Data::type_properties(field.type).flags & Data::VTP_DYNAMIC_SIZE
+				) {
+					strings.emplace_back(field.data.string, field.size);
+					field.data.string = strings.back().data();
+				}
+			}
+		}
+		append_batch(num_records, num_fields, fields.data());
+	}
+
 	/**
 		Remove a record.
 	*/
@@ -407,8 +1523,70 @@ public:
 		Data::Table::Iterator& it
 	) noexcept;
 
+	/**
+		Remove selected records.
+
+		@note Each chunk with selected records is compacted once and
+		chunks left empty are freed, in one pass over the chunks.
+		@a selection must have one bit for every record.
+
+		@returns Number of removed records.
+		@sa select()
+	*/
+	unsigned
+	remove(
+		Data::Table::Selection const& selection
+	) noexcept;
+
+	/**
+		Remove records matching a predicate.
+
+		@par
+		@code
+		bool predicate(Data::Table::Iterator const& it);
+		@endcode
+		@a predicate is called for every record in order and must
+		not modify the table.
+
+		@returns Number of removed records.
+		@sa remove(Data::Table::Selection const&)
+	*/
+	template<class F>
+	unsigned
+	remove_if(
+		F&& predicate
+	) {
+		Data::Table::Selection selection{};
+		selection.reset(m_num_records, false);
+		unsigned index = 0;
+		for (auto it = begin(); it.can_advance(); ++it, ++index) {
+			if (predicate(static_cast<Data::Table::Iterator const&>(it))) {
+				selection.bits[index >> 6] |= std::uint64_t{1} << (index & 63);
+			}
+		}
+		return remove(selection);
+	}
+
+	/**
+		Remove records in a range.
+
+		@param first Iterator at the first record to remove.
+		@param last Iterator after the last record to remove.
+
+		@returns Number of removed records.
+		@sa remove(Data::Table::Selection const&)
+	*/
+	unsigned
+	erase(
+		Data::Table::Iterator const& first,
+		Data::Table::Iterator const& last
+	) noexcept;
+
 	/**
 		Set field value.
+
+		@throws Error{ErrorCode::table_dictionary_full}
+		@sa insert()
 	*/
 	void
 	set_field(
@@ -419,12 +1597,251 @@ public:
 
 	/**
 		Get field value.
+
+		@note Values of dictionary-coded columns point into the
+		column's dictionary, which is valid until the table is
+		cleared or reconfigured.
 	*/
 	Data::ValueRef
 	get_field(
 		Data::Table::Iterator const& it,
 		unsigned const column_index
 	) const noexcept;
+
+	/**
+		Get the masked field values at a cursor.
+
+		@note Fields are located up to the last masked column. Values
+		are as from get_field().
+
+		@sa Cursor
+	*/
+	void
+	get_fields(
+		Data::Table::Cursor& cursor
+	) const;
+/// @}
+
+/** @name Sorting */ /// @{
+	/**
+		Sort records by columns.
+
+		@note Records are ordered by the first column, then by each
+		following column where fields are equal. Records with equal
+		fields keep their relative order. Strings are ordered
+		bytewise, decimals by total order, and dynamic fields by
+		type first. Keys are sorted first and chunks are then
+		rebuilt in one pass. Index entries are kept; only their
+		record order is rebuilt.
+
+		@throws Error{ErrorCode::table_column_index_invalid}
+		If a column index is out-of-bounds.
+	*/
+	void
+	sort_by(
+		aux::vector<unsigned> const& column_indices,
+		Data::Table::Order const order = Data::Table::Order::ascending
+	);
+
+	/**
+		Insert a record into a sorted table.
+
+		@note The table must be ordered as sort_by() would order it
+		with the same columns and order. The insertion point is found
+		by binary search, after any records with equal fields.
+
+		@throws Error{ErrorCode::table_column_index_invalid}
+		If a column index is out-of-bounds.
+		@throws Error{ErrorCode::table_dictionary_full}
+		If a dictionary-coded column has no code left for a new value.
+
+		@returns Iterator at the inserted record.
+		@sa insert()
+	*/
+	Data::Table::Iterator
+	insert_sorted(
+		aux::vector<unsigned> const& column_indices,
+		Data::Table::Order const order,
+		unsigned num_fields,
+		Data::ValueRef* const fields
+	);
+/// @}
+
+/** @name Aggregation */ /// @{
+	/**
+		Aggregate a column.
+
+		@note Values are read directly from chunks with a decoder
+		specialized to the column type. Fixed-stride and columnar
+		chunks are aggregated in contiguous loops.
+
+		@returns An empty aggregate if the column is not an integer
+		or decimal column.
+	*/
+	Data::Table::Aggregate
+	aggregate(
+		unsigned const column_index
+	) const noexcept;
+/// @}
+
+/** @name Selection */ /// @{
+	/**
+		Select records matching a filter.
+
+		@note Each term is evaluated over its column by a kernel
+		specialized to the column type. Chunks are skipped without
+		being decoded if their zones or filters rule out a match.
+		Terms with out-of-bounds columns match nothing, and a filter
+		without terms matches every record.
+
+		@returns Number of selected records.
+	*/
+	unsigned
+	select(
+		Data::Table::Filter const& filter,
+		Data::Table::Selection& selection
+	) const;
+
+	/**
+		Select indices of records matching a filter.
+
+		@returns Number of selected records.
+	*/
+	unsigned
+	select(
+		Data::Table::Filter const& filter,
+		aux::vector<unsigned>& indices
+	) const {
+		Data::Table::Selection selection{};
+		unsigned const count = select(filter, selection);
+		selection.indices(indices);
+		return count;
+	}
+/// @}
+
+/** @name Indexing */ /// @{
+	/**
+		Get indexed column.
+
+		@returns The indexed column, or @c ~0u if no column is
+		indexed.
+	*/
+	unsigned
+	index_column() const noexcept {
+		return m_index.column;
+	}
+
+	/**
+		Set indexed column.
+
+		@note The index is maintained by modifications, rebuilt by
+		read() and configure(), and dropped if its column is
+		removed. Entries refer to records by stable IDs, so inserting
+		or removing a record is logarithmic in the number of records
+		wherever it is in the table.
+
+		@param column_index Column to index, or @c ~0u to drop the
+		index.
+	*/
+	void
+	set_index_column(
+		unsigned const column_index
+	) noexcept;
+
+	/**
+		Get ordered-indexed column.
+
+		@returns The ordered-indexed column, or @c ~0u if no column is
+		ordered-indexed.
+	*/
+	unsigned
+	ordered_index_column() const noexcept {
+		return m_ordered_index.column;
+	}
+
+	/**
+		Set ordered-indexed column.
+
+		@note Only integer, decimal, and object ID columns can be
+		ordered-indexed. The index is otherwise maintained like the
+		hash index.
+
+		@param column_index Column to index, or @c ~0u to drop the
+		index.
+
+		@sa set_index_column()
+	*/
+	void
+	set_ordered_index_column(
+		unsigned const column_index
+	) noexcept;
+
+	/**
+		Get whether a column has chunk filters.
+	*/
+	bool
+	bloom_column(
+		unsigned const column_index
+	) const noexcept;
+
+	/**
+		Set whether a column has chunk filters.
+
+		Chunk filters are Bloom filters of the values of a column in
+		each chunk. Equality selections skip chunks whose filters
+		rule out the value, which serves point lookups on columns
+		not worth a full index at a fraction of its memory.
+
+		@note Only string (except dictionary-coded) and object ID
+		columns can have filters. Filters are built by
+		compact_storage() and write(), and read with the chunks.
+		The setting itself is not serialized, and it is dropped if
+		the column is removed.
+
+		@returns @c true if the setting changed.
+	*/
+	bool
+	set_bloom_column(
+		unsigned const column_index,
+		bool const enable
+	);
+
+	/**
+		Find the first record with a field equal to a value.
+
+		@note Values are compared exactly after conversion to the
+		column's type. This is logarithmic (expected, per matching
+		hash) if @a column_index is the indexed column, and linear
+		otherwise.
+
+		@returns Iterator at the record, or end() if no record
+		matches.
+	*/
+	Data::Table::Iterator
+	find(
+		unsigned const column_index,
+		Data::ValueRef value
+	);
+
+	/**
+		Select indices of records with a field in a closed range.
+
+		@note Bounds are converted to the column's type. Decimals are
+		compared by total order. This is logarithmic plus linear in
+		the number of selected records if @a column_index is the
+		ordered-indexed column, and linear otherwise.
+
+		@returns Number of selected records, in ascending order of
+		index. This is @c 0 if the column is not an integer, decimal,
+		or object ID column.
+	*/
+	unsigned
+	select_range(
+		unsigned const column_index,
+		Data::ValueRef lower,
+		Data::ValueRef upper,
+		aux::vector<unsigned>& indices
+	);
 /// @}
 
 /** @name Serialization */ /// @{
@@ -440,6 +1857,41 @@ public:
 		InputSerializer& ser
 	);
 
+	/**
+		Read from serialized data in memory without copying chunks.
+
+		@note Chunks that were written as they are stored reference
+		@a data directly instead of being copied. They are copied
+		when first modified. Column-encoded chunks are decoded into
+		allocated chunks.
+
+		@warning @a data must remain valid and unmodified until
+		release_mapped() is called or the table and every table
+		sharing its chunks are cleared or destroyed.
+
+		@throws Error{ErrorCode::serialization_data_malformed}
+		If chunk data extends past the end of @a data.
+		@throws SerializerError{..}
+		If a serialization operation failed.
+
+		@returns Number of bytes read from @a data.
+		@sa release_mapped()
+	*/
+	std::size_t
+	read_mapped(
+		std::uint8_t const* const data,
+		std::size_t const size
+	);
+
+	/**
+		Copy chunks that reference the data given to read_mapped().
+
+		@note Tables sharing chunks with this table through assign()
+		must release them separately.
+	*/
+	void
+	release_mapped() noexcept;
+
 	/**
 		Write to output serializer.
 
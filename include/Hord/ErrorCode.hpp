@@ -61,6 +61,10 @@ enum class ErrorCode : unsigned {
 		Attempted to configure a table with a non-unique column.
 	*/
 	table_column_name_shared,
+	/**
+		Attempted to add a value to a full column dictionary.
+	*/
+	table_dictionary_full,
 /// @}
 
 /** @name Driver */ /// @{
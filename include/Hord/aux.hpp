@@ -13,6 +13,7 @@
 #include <string>
 #include <vector>
 #include <deque>
+#include <map>
 #include <unordered_map>
 #include <unordered_set>
 
@@ -72,6 +73,35 @@ using unordered_map
 	HORD_AUX_ALLOCATOR<std::pair<Key const, T> >
 >;
 
+/**
+	@c std::multimap<Key, T, Compare>.
+*/
+template<
+	class Key,
+	class T,
+	class Compare = std::less<Key>
+>
+using multimap
+= std::multimap<
+	Key, T, Compare,
+	HORD_AUX_ALLOCATOR<std::pair<Key const, T> >
+>;
+
+/**
+	@c std::unordered_multimap<Key, T, Hash, KeyEqual>.
+*/
+template<
+	class Key,
+	class T,
+	class Hash = std::hash<Key>,
+	class KeyEqual = std::equal_to<Key>
+>
+using unordered_multimap
+= std::unordered_multimap<
+	Key, T, Hash, KeyEqual,
+	HORD_AUX_ALLOCATOR<std::pair<Key const, T> >
+>;
+
 /**
 	@c std::unordered_set<Key, Hash, KeyEqual>.
 */
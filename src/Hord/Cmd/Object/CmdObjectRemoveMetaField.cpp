@@ -66,14 +66,11 @@ HORD_SCOPE_CLASS::operator()(
 	m_object_id = object.id();
 	m_field_index = -1;
 
-	auto it = object.metadata().table().begin();
-	for (; it.can_advance(); ++it) {
-		auto const value_ref = it.get_field(Data::Metadata::COL_NAME);
-		if (string_equal(name, value_ref.size, value_ref.data.string)) {
-			m_field_index = signed_cast(it.index);
-			remove_field(object, it);
-			return commit();
-		}
+	auto it = object.metadata().table().find(Data::Metadata::COL_NAME, {name});
+	if (it.can_advance()) {
+		m_field_index = signed_cast(it.index);
+		remove_field(object, it);
+		return commit();
 	}
 	return commit_error("field does not exist");
 } catch (...) {
@@ -34,17 +34,16 @@ HORD_SCOPE_CLASS::set_name(
 		set_message("new name must not be empty");
 		return Cmd::Result::error;
 	}
-	auto it_search = object.metadata().table().begin();
-	for (; it_search.can_advance(); ++it_search) {
-		auto const value_ref = it_search.get_field(Data::Metadata::COL_NAME);
-		if (!string_equal(new_name, value_ref.size, value_ref.data.string)) {
-			// Do nothing
-		} else if (it_search == it) {
-			return Cmd::Result::success_no_action;
-		} else {
-			set_message("another field already has this name");
-			return Cmd::Result::error;
-		}
+	auto const it_search = object.metadata().table().find(
+		Data::Metadata::COL_NAME, {new_name}
+	);
+	if (!it_search.can_advance()) {
+		// Do nothing
+	} else if (it_search == it) {
+		return Cmd::Result::success_no_action;
+	} else {
+		set_message("another field already has this name");
+		return Cmd::Result::error;
 	}
 
 	it.set_field(Data::Metadata::COL_NAME, new_name);
@@ -87,13 +86,10 @@ HORD_SCOPE_CLASS::operator()(
 	m_object_id = object.id();
 	m_field_index = -1;
 
-	auto it = object.metadata().table().begin();
-	for (; it.can_advance(); ++it) {
-		auto const value_ref = it.get_field(Data::Metadata::COL_NAME);
-		if (string_equal(old_name, value_ref.size, value_ref.data.string)) {
-			m_field_index = signed_cast(it.index);
-			return commit_with(set_name(object, it, new_name));
-		}
+	auto it = object.metadata().table().find(Data::Metadata::COL_NAME, {old_name});
+	if (it.can_advance()) {
+		m_field_index = signed_cast(it.index);
+		return commit_with(set_name(object, it, new_name));
 	}
 	return commit_error("field does not exist");
 } catch (...) {
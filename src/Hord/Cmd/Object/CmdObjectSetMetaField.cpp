@@ -75,14 +75,11 @@ HORD_SCOPE_CLASS::operator()(
 	if (name.empty()) {
 		return commit_error("empty name");
 	}
-	auto it = object.metadata().table().begin();
-	for (; it.can_advance(); ++it) {
-		auto const value_ref = it.get_field(Data::Metadata::COL_NAME);
-		if (string_equal(name, value_ref.size, value_ref.data.string)) {
-			m_field_index = signed_cast(it.index);
-			set_value(object, it, new_value);
-			return commit();
-		}
+	auto it = object.metadata().table().find(Data::Metadata::COL_NAME, {name});
+	if (it.can_advance()) {
+		m_field_index = signed_cast(it.index);
+		set_value(object, it, new_value);
+		return commit();
 	}
 	if (create) {
 		Data::ValueRef fields[2];
@@ -0,0 +1,99 @@
+/**
+@copyright MIT license; see @ref index or the accompanying LICENSE file.
+*/
+
+#include <Hord/utility.hpp>
+#include <Hord/Data/ChunkAllocator.hpp>
+
+#include <duct/debug.hpp>
+
+namespace Hord {
+namespace Data {
+
+// class ChunkAllocator implementation
+
+ChunkAllocator::~ChunkAllocator() = default;
+
+Data::ChunkAllocator&
+ChunkAllocator::default_allocator() noexcept {
+	// NB: Never destroyed so tables with static storage can outlive it
+	static Data::ChunkPool* const s_pool = new Data::ChunkPool();
+	return *s_pool;
+}
+
+// class ChunkPool implementation
+
+ChunkPool::~ChunkPool() noexcept {
+	release();
+}
+
+ChunkPool::ChunkPool(
+	unsigned const class_limit
+)
+	: m_class_limit(class_limit)
+{
+	// NB: Retaining data must not allocate
+	for (auto& free_data : m_classes) {
+		free_data.reserve(m_class_limit);
+	}
+}
+
+std::uint8_t*
+ChunkPool::allocate_impl(
+	unsigned& size
+) {
+	unsigned const size_class = (max_ce(size, 1u) - 1) / GRANULARITY;
+	size = (size_class + 1) * GRANULARITY;
+	if (size_class < NUM_CLASSES) {
+		std::lock_guard<std::mutex> lock{m_mutex};
+		auto& free_data = m_classes[size_class];
+		if (!free_data.empty()) {
+			auto* const data = free_data.back();
+			free_data.pop_back();
+			return data;
+		}
+	}
+	return new std::uint8_t[size];
+}
+
+void
+ChunkPool::free_impl(
+	std::uint8_t* const data,
+	unsigned const size
+) noexcept {
+	DUCT_DEBUG_ASSERTE(size % GRANULARITY == 0);
+	unsigned const size_class = size / GRANULARITY - 1;
+	if (size_class < NUM_CLASSES) {
+		std::lock_guard<std::mutex> lock{m_mutex};
+		auto& free_data = m_classes[size_class];
+		if (free_data.size() < m_class_limit) {
+			free_data.push_back(data);
+			return;
+		}
+	}
+	delete[] data;
+}
+
+void
+ChunkPool::release() noexcept {
+	std::lock_guard<std::mutex> lock{m_mutex};
+	for (auto& free_data : m_classes) {
+		for (auto* const data : free_data) {
+			delete[] data;
+		}
+		free_data.clear();
+	}
+}
+
+unsigned
+ChunkPool::num_retained() noexcept {
+	std::lock_guard<std::mutex> lock{m_mutex};
+	unsigned count = 0;
+	for (auto const& free_data : m_classes) {
+		count += free_data.size();
+	}
+	return count;
+}
+
+} // namespace Data
+} // namespace Hord
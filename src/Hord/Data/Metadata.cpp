@@ -44,6 +44,7 @@ Metadata::deserialize(
 	Data::Table des_table{};
 	ser(des_table);
 	des_table.configure(Data::Metadata::s_schema);
+	des_table.set_index_column(Data::Metadata::COL_NAME);
 
 	// commit
 	m_table.operator=(std::move(des_table));
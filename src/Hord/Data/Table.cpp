@@ -13,7 +13,17 @@
 
 #include <duct/debug.hpp>
 
+#include <algorithm>
+#include <atomic>
+#include <cmath>
 #include <cstring>
+#include <functional>
+#include <istream>
+#include <limits>
+#include <streambuf>
+#include <system_error>
+#include <thread>
+#include <type_traits>
 #include <utility>
 
 #include <Hord/detail/gr_ceformat.hpp>
@@ -26,11 +36,72 @@ namespace {
 constexpr static unsigned const
 CHUNK_SIZE = 0x2000;
 
+// Chunks are compacted when record slack exceeds 1/N of used space
+constexpr static unsigned const
+CHUNK_COMPACT_DIVISOR = 4;
+
+// Chunks are column-encoded when it saves more than 1/N of used space
+constexpr static unsigned const
+CHUNK_ENCODE_DIVISOR = 8;
+
+// Minimum number of chunks given to each migration worker
+constexpr static unsigned const
+MIGRATE_CHUNKS_PER_WORKER = 0x40;
+
+// Initial value of any type (including dynamic) as written
+constexpr static std::uint8_t const
+INIT_VALUE_DATA[0x10]{};
+
 struct Record {
 	unsigned size;
 	std::uint8_t* data;
 };
 
+// Size of an unsigned LEB128 varint
+inline static unsigned
+varint_size(
+	unsigned value
+) noexcept {
+	unsigned size = 1;
+	for (; 0x80 <= value; value >>= 7) {
+		++size;
+	}
+	return size;
+}
+
+inline static unsigned
+varint_write(
+	unsigned value,
+	std::uint8_t* const output
+) noexcept {
+	unsigned size = 0;
+	for (; 0x80 <= value; value >>= 7) {
+		output[size++] = static_cast<std::uint8_t>(value | 0x80);
+	}
+	output[size++] = static_cast<std::uint8_t>(value);
+	return size;
+}
+
+inline static unsigned
+varint_read(
+	std::uint8_t const* const data,
+	unsigned& value
+) noexcept {
+	// NB: Fast path for records shorter than 0x80 bytes
+	if (data[0] < 0x80) {
+		value = data[0];
+		return 1;
+	}
+	value = data[0] & 0x7F;
+	unsigned size = 1;
+	unsigned shift = 7;
+	do {
+		value |= static_cast<unsigned>(data[size] & 0x7F) << shift;
+		shift += 7;
+	} while (data[size++] & 0x80);
+	return size;
+}
+
 /*inline static unsigned
 value_zero_size(
 	Data::Type const type
@@ -186,7 +257,9 @@ value_write(
 		}
 		output += meta_size;
 		// NB: When modifying a record, the destination and source could overlap
-		std::memmove(output, value.data.dynamic, value.size);
+		if (0 < value.size) {
+			std::memmove(output, value.data.dynamic, value.size);
+		}
 		output += value.size;
 	} else {
 		unsigned const size = vp.fixed_size[enum_cast(value.type.size())];
@@ -208,20 +281,35 @@ chunk_clear(
 	chunk.head = chunk.data;
 	chunk.tail = chunk.data;
 	chunk.num_records = 0;
+	chunk.marks.clear();
+	chunk.zones.clear();
+	chunk.blooms.clear();
 }
 
 static void
 chunk_free(
 	Data::Table::Chunk& chunk
 ) noexcept {
-	if (chunk.data) {
-		delete[] chunk.data;
+	// NB: The last owner frees shared data
+	if (
+		chunk.refs &&
+		chunk.refs->fetch_sub(1, std::memory_order_acq_rel) == 1
+	) {
+		delete chunk.refs;
+		if (!chunk.borrowed) {
+			chunk.allocator->free(chunk.data, chunk.size);
+		}
 	}
+	chunk.refs = nullptr;
+	chunk.borrowed = false;
 	chunk.data = nullptr;
 	chunk.head = nullptr;
 	chunk.tail = nullptr;
 	chunk.size = 0;
 	chunk.num_records = 0;
+	chunk.marks.clear();
+	chunk.zones.clear();
+	chunk.blooms.clear();
 }
 
 static void
@@ -231,8 +319,13 @@ chunk_allocate(
 ) noexcept {
 	DUCT_ASSERTE(size > 0);
 	chunk_free(chunk);
-	chunk.data = new std::uint8_t[size];
-	chunk.size = size;
+	if (!chunk.allocator) {
+		chunk.allocator = &Data::ChunkAllocator::default_allocator();
+	}
+	unsigned allocated_size = size;
+	chunk.data = chunk.allocator->allocate(allocated_size);
+	chunk.size = allocated_size;
+	chunk.refs = new std::atomic<unsigned>{1};
 	chunk_clear(chunk);
 }
 
@@ -253,12 +346,21 @@ chunk_split(
 	// 3. head of tail chunk
 	// to work better under common usage patterns
 	unsigned const size = end - begin;
+	split.allocator = chunk.allocator;
+	split.version = chunk.version;
 	chunk_allocate(split, max_ce(min_size, head_space + size + tail_space));
 	split.head += head_space;
 	split.tail = split.head + size;
 	std::memcpy(split.head, chunk.data + begin, size);
 	split.num_records = num_records;
+	split.dirty = chunk.dirty;
 	chunk.num_records -= num_records;
+	if (begin == chunk.offset_head()) {
+		chunk.head = chunk.data + end;
+	} else {
+		chunk.tail = chunk.data + begin;
+	}
+	chunk.marks.clear();
 }
 
 static void
@@ -267,15 +369,17 @@ chunk_split_head(
 	Data::Table::Chunk& split,
 	Data::Table::Iterator& it,
 	unsigned const min_size,
+	unsigned const segment_size,
 	unsigned const tail_space
 ) {
+	// NB: An existing segment at the iterator moves with the head
 	chunk_split(
 		chunk, split,
-		min_size, it.inner_index,
-		chunk.offset_head(), it.data_offset,
+		min_size, it.inner_index + (0 < segment_size ? 1 : 0),
+		chunk.offset_head(), it.data_offset + segment_size,
 		0, tail_space
 	);
-	it.data_offset = split.offset_tail();
+	it.data_offset = split.offset_tail() - segment_size;
 }
 
 static void
@@ -312,8 +416,11 @@ chunk_set_bounds(
 	chunk.num_records = num_records;
 	chunk.head = chunk.data + head;
 	chunk.tail = chunk.data + tail;
+	chunk.marks.clear();
 }
 
+// NB: The leading min(old_size, new_size) bytes of the segment are
+// retained
 static bool
 segment_resize(
 	Data::Table::Chunk& chunk,
@@ -325,96 +432,233 @@ segment_resize(
 	if (old_size == new_size) {
 		return false;
 	}
+	chunk.marks.clear();
 	// TODO: Insertion into adjacent chunks
 	// TODO: Move both sections if the value fits within their sum,
 	// but not within them individually
 	// TODO: Minimum segment size by type
 	unsigned const from_head = it.data_offset - chunk.offset_head();
-	unsigned const from_tail = chunk.offset_tail() - it.data_offset;
+	unsigned const from_tail = chunk.offset_tail() - it.data_offset - old_size;
+	unsigned const keep_size = min_ce(old_size, new_size);
 	unsigned const diff
 		= old_size > new_size
 		? old_size - new_size
 		: new_size - old_size
 	;
+	auto* const segment = chunk.data + it.data_offset;
 	if (old_size > new_size) {
 		if (from_head < from_tail) {
-			std::memmove(chunk.head + diff, chunk.head, from_head);
+			std::memmove(chunk.head + diff, chunk.head, from_head + keep_size);
 			chunk.head += diff;
 			it.data_offset += diff;
 		} else {
-			std::memmove(chunk.head + from_head + new_size, chunk.head + from_head + old_size, from_tail - old_size);
+			std::memmove(segment + new_size, segment + old_size, from_tail);
 			chunk.tail -= diff;
 		}
-	} else if (chunk.space_head() >= new_size) {
-		std::memmove(chunk.head - diff, chunk.head, from_head);
+	} else if (
+		chunk.space_head() >= diff &&
+		(from_head < from_tail || chunk.space_tail() < diff)
+	) {
+		std::memmove(chunk.head - diff, chunk.head, from_head + keep_size);
 		chunk.head -= diff;
 		it.data_offset -= diff;
-	} else if (chunk.space_tail() >= new_size) {
-		std::memmove(chunk.head + from_head + new_size, chunk.head + from_head + old_size, from_tail - old_size);
+	} else if (chunk.space_tail() >= diff) {
+		std::memmove(segment + new_size, segment + old_size, from_tail);
 		chunk.tail += diff;
 	} else if (from_head < from_tail) {
-		chunk_split_head(chunk, split, it, max_ce(new_size, CHUNK_SIZE), new_size);
-		split.tail += new_size;
+		chunk_split_head(chunk, split, it, max_ce(new_size, CHUNK_SIZE), old_size, diff);
+		split.tail += diff;
 		return true;
 	} else {
-		chunk_split_tail(chunk, split, it, max_ce(new_size, CHUNK_SIZE), new_size);
-		split.head -= new_size;
-		it.data_offset -= new_size;
+		chunk_split_tail(chunk, split, it, max_ce(new_size, CHUNK_SIZE), diff);
+		split.head -= diff;
+		it.data_offset -= diff;
+		std::memmove(split.head, split.head + diff, keep_size);
 		return true;
 	}
 	return false;
 }
 
-inline constexpr static unsigned
-record_meta_size() {
-	return sizeof(std::uint32_t);
+inline static unsigned
+column_fixed_size(
+	Data::Type const type
+) noexcept {
+	if (type.type() == Data::ValueType::dynamic) {
+		return ~0u;
+	}
+	auto const& vp = Data::type_properties(type);
+	if (vp.flags & Data::VTP_DYNAMIC_SIZE) {
+		return ~0u;
+	} else {
+		return vp.fixed_size[enum_cast(type.size())];
+	}
+}
+
+inline static bool
+type_sparse(
+	Data::Type const type
+) noexcept {
+	return enum_cast(type.flags() & Data::ValueFlag::field_sparse);
+}
+
+static void
+record_format_build(
+	Data::Table::RecordFormat& format,
+	Data::Table::Layout const layout,
+	bool const compact,
+	Data::TableSchema::column_vector_type const& columns,
+	bool const allow_stride = true
+) {
+	unsigned const num_columns = columns.size();
+	format.layout = layout;
+	format.compact = compact;
+	format.walk_column = num_columns;
+	format.field_offsets.assign(num_columns, ~0u);
+	format.field_slots.assign(num_columns, ~0u);
+	format.slot_columns.clear();
+	format.sparse_bits.assign(num_columns, ~0u);
+	format.sparse_columns.clear();
+	format.init_sizes.resize(num_columns);
+	unsigned offset = 0;
+	unsigned size;
+	for (unsigned index = 0; index < num_columns; ++index) {
+		if (type_sparse(columns[index].type)) {
+			// Stored after the regular fields only when present
+			format.init_sizes[index] = 0;
+			format.sparse_bits[index] = format.sparse_columns.size();
+			format.sparse_columns.push_back(index);
+			continue;
+		}
+		format.init_sizes[index] = value_init_size(columns[index].type);
+		size = column_fixed_size(columns[index].type);
+		if (layout == Data::Table::Layout::indexed) {
+			if (size == ~0u) {
+				format.field_slots[index] = format.slot_columns.size();
+				format.slot_columns.push_back(index);
+			} else {
+				format.field_offsets[index] = offset;
+				offset += size;
+			}
+		} else if (format.walk_column == num_columns) {
+			// Offsets are constant up to the first variably-sized field
+			format.field_offsets[index] = offset;
+			if (size == ~0u) {
+				format.walk_column = index;
+			} else {
+				offset += size;
+			}
+		}
+	}
+	format.fixed_size = offset;
+	format.slots_size = 0;
+	format.stride = 0;
+	if (!format.slot_columns.empty()) {
+		format.field_offsets[format.slot_columns.front()] = offset;
+		format.slots_size = (format.slot_columns.size() - 1) * sizeof(std::uint32_t);
+	} else if (
+		allow_stride &&
+		format.walk_column == num_columns &&
+		format.sparse_columns.empty() &&
+		0 < format.fixed_size
+	) {
+		// Every record is the same size; drop the header
+		format.stride = format.fixed_size;
+	}
+	format.columnar = layout == Data::Table::Layout::columnar && format.stride;
+}
+
+// Size of the header of a record
+inline static unsigned
+record_meta_size(
+	Data::Table::RecordFormat const& format,
+	unsigned const data_size
+) noexcept {
+	if (format.stride) {
+		return 0;
+	}
+	return
+		(format.compact ? varint_size(data_size) : sizeof(std::uint32_t)) +
+		format.slots_size
+	;
 }
 
-inline constexpr static unsigned
+inline static unsigned
 record_written_size(
+	Data::Table::RecordFormat const& format,
 	unsigned const data_size
 ) {
-	return record_meta_size() + data_size;
+	return record_meta_size(format, data_size) + data_size;
 }
 
 inline static unsigned
 record_written_size(
+	Data::Table::RecordFormat const& format,
 	Record const& record
 ) {
-	return record_written_size(record.size);
+	return record_written_size(format, record.size);
 }
 
+// Write the size of a record and get the size of the size
 inline static unsigned
 record_write_size(
-	Record const& record,
-	std::uint8_t* output
+	Data::Table::RecordFormat const& format,
+	unsigned const size,
+	std::uint8_t* const output
 ) {
-	*reinterpret_cast<std::uint32_t*>(output) = record.size;
-	return record_meta_size();
+	if (format.stride) {
+		return 0;
+	} else if (format.compact) {
+		return varint_write(size, output);
+	}
+	*reinterpret_cast<std::uint32_t*>(output) = size;
+	return sizeof(std::uint32_t);
 }
 
 static unsigned
 record_write(
+	Data::Table::RecordFormat const& format,
 	Record const& record,
 	std::uint8_t* output
 ) {
-	output += record_write_size(record, output);
-	std::memcpy(output, record.data, record.size);
-	return record_meta_size() + record.size;
+	// NB: Offset array and data are contiguous
+	output += record_write_size(format, record.size, output);
+	std::memcpy(
+		output,
+		record.data - format.slots_size,
+		format.slots_size + record.size
+	);
+	return record_written_size(format, record);
 }
 
-static Record
+inline static Record
 record_read(
+	Data::Table::RecordFormat const& format,
 	std::uint8_t* data
 ) {
-	return {
-		*reinterpret_cast<std::uint32_t const*>(data),
-		data + record_meta_size()
-	};
+	if (format.stride) {
+		return {format.stride, data};
+	}
+	unsigned size;
+	if (format.compact) {
+		data += varint_read(data, size);
+	} else {
+		size = *reinterpret_cast<std::uint32_t const*>(data);
+		data += sizeof(std::uint32_t);
+	}
+	return {size, data + format.slots_size};
+}
+
+inline static std::uint32_t*
+record_slots(
+	Data::Table::RecordFormat const& format,
+	Record const& record
+) noexcept {
+	return reinterpret_cast<std::uint32_t*>(record.data - format.slots_size);
 }
 
 static bool
 record_resize(
+	Data::Table::RecordFormat const& format,
 	Record& record,
 	Data::Table::Chunk& chunk,
 	Data::Table::Chunk& split,
@@ -424,20 +668,40 @@ record_resize(
 	if (record.size == new_size) {
 		return false;
 	}
+	// NB: A compact header changes size with the record, so the
+	// offset array and data are shifted within the kept bytes
+	unsigned const old_meta_size = record_meta_size(format, record.size);
+	unsigned const new_meta_size = record_meta_size(format, new_size);
+	unsigned const body_size = format.slots_size + min_ce(record.size, new_size);
+	if (new_meta_size < old_meta_size) {
+		auto* const segment = chunk.data + it.data_offset;
+		std::memmove(
+			segment + new_meta_size - format.slots_size,
+			segment + old_meta_size - format.slots_size,
+			body_size
+		);
+	}
 	bool const record_moved = segment_resize(
 		chunk, split, it,
-		record_written_size(record),
-		record_meta_size() + new_size
+		old_meta_size + record.size,
+		new_meta_size + new_size
 	);
 	record.size = new_size;
 	record.data = (record_moved ? split.data : chunk.data) + it.data_offset;
-	*reinterpret_cast<std::uint32_t*>(record.data) = record.size;
-	record.data += record_meta_size();
+	if (old_meta_size < new_meta_size) {
+		std::memmove(
+			record.data + new_meta_size - format.slots_size,
+			record.data + old_meta_size - format.slots_size,
+			body_size
+		);
+	}
+	record.data += record_write_size(format, record.size, record.data) + format.slots_size;
 	return record_moved;
 }
 
 static bool
 record_make(
+	Data::Table::RecordFormat const& format,
 	Record& record,
 	Data::Table::Chunk& chunk,
 	Data::Table::Chunk& split,
@@ -446,185 +710,2192 @@ record_make(
 ) {
 	bool const record_moved = segment_resize(
 		chunk, split, it,
-		0, record_meta_size() + size
+		0, record_written_size(format, size)
 	);
 	record.size = size;
 	record.data = (record_moved ? split.data : chunk.data) + it.data_offset;
-	*reinterpret_cast<std::uint32_t*>(record.data) = record.size;
-	record.data += record_meta_size();
+	record.data += record_write_size(format, record.size, record.data) + format.slots_size;
 	return record_moved;
 }
 
-static unsigned
-field_offset(
-	Record const& record,
-	Data::TableSchema const& schema,
-	unsigned index
+// Size of the presence bitmap of sparse fields
+inline static unsigned
+record_sparse_size(
+	Data::Table::RecordFormat const& format
 ) noexcept {
-	unsigned const num = min_ce(index, schema.num_columns());
-	unsigned offset = 0;
-	for (index = 0; index < num; ++index) {
-		offset += value_read_size_whole(schema.column(index).type, record.data + offset);
-	}
-	DUCT_DEBUG_ASSERTE(offset <= record.size);
-	return offset;
+	return (format.sparse_columns.size() + 7) / 8;
 }
 
-inline static unsigned
-record_data_size(
-	Record const& record,
-	Data::TableSchema const& schema
+inline static bool
+sparse_present(
+	std::uint8_t const* const bits,
+	unsigned const bit
 ) noexcept {
-	return field_offset(record, schema, schema.num_columns());
+	return (bits[bit >> 3] >> (bit & 7)) & 1;
 }
 
-} // anonymous namespace
-
-// class Table::Iterator implementation
+// Whether a value reads the same as an absent sparse field
+static bool
+value_initial(
+	Data::ValueRef const& value,
+	bool const is_dynamic
+) noexcept {
+	if (is_dynamic || value.type.type() == Data::ValueType::null) {
+		return value.type.type() == Data::ValueType::null;
+	}
+	unsigned const size = value_data_size(value);
+	if (Data::type_properties(value.type).flags & Data::VTP_DYNAMIC_SIZE) {
+		return size == 0;
+	}
+	return std::memcmp(&value.data, INIT_VALUE_DATA, size) == 0;
+}
 
-Table::Iterator&
-Table::Iterator::operator++() noexcept {
-	++index;
-	if (index < table->m_num_records) {
-		auto const* chunk = &table->m_chunks[chunk_index];
-		++inner_index;
-		if (inner_index < chunk->num_records) {
-			auto const record = record_read(chunk->data + data_offset);
-			data_offset += record_written_size(record);
-			DUCT_DEBUG_ASSERTE(data_offset <= chunk->size);
+static unsigned
+record_write_values(
+	Data::Table::RecordFormat const& format,
+	Data::TableSchema::column_vector_type const& columns,
+	unsigned const size,
+	unsigned const num_values,
+	Data::ValueRef const* const values,
+	std::uint8_t* const output
+) {
+	auto* const slots = reinterpret_cast<std::uint32_t*>(
+		output + record_write_size(format, size, output)
+	);
+	auto* const data = reinterpret_cast<std::uint8_t*>(slots) + format.slots_size;
+	bool const indexed = format.layout == Data::Table::Layout::indexed;
+	unsigned const num_columns = columns.size();
+	unsigned offset = indexed ? format.fixed_size : 0;
+	unsigned slot;
+	Data::ValueRef value;
+	for (unsigned index = 0; index < num_columns; ++index) {
+		auto const type = columns[index].type;
+		bool const is_dynamic = type.type() == Data::ValueType::dynamic;
+		if (index < num_values) {
+			value = values[index];
+		} else if (is_dynamic) {
+			value = {};
 		} else {
-			++chunk_index;
-			inner_index = 0;
-			DUCT_ASSERTE(chunk_index < table->m_chunks.size());
-			chunk = &table->m_chunks[chunk_index];
-			data_offset = chunk->offset_head();
+			value = {type};
+		}
+		slot = format.field_slots[index];
+		if (format.sparse_bits[index] != ~0u) {
+			continue;
+		} else if (!indexed) {
+			offset += value_write(value, data + offset, is_dynamic);
+		} else if (slot == ~0u) {
+			value_write(value, data + format.field_offsets[index], false);
+		} else {
+			if (0 < slot) {
+				slots[slot - 1] = offset;
+			}
+			offset += value_write(value, data + offset, is_dynamic);
 		}
 	}
-	return *this;
+	if (!format.sparse_columns.empty()) {
+		// Presence bitmap, then present sparse fields in column order
+		auto* const bits = data + offset;
+		unsigned const bitmap_size = record_sparse_size(format);
+		std::memset(bits, 0, bitmap_size);
+		offset += bitmap_size;
+		unsigned bit = 0;
+		for (unsigned const index : format.sparse_columns) {
+			bool const is_dynamic = columns[index].type.type() == Data::ValueType::dynamic;
+			if (index < num_values && !value_initial(values[index], is_dynamic)) {
+				bits[bit >> 3] |= 1u << (bit & 7);
+				offset += value_write(values[index], data + offset, is_dynamic);
+			}
+			++bit;
+		}
+	}
+	DUCT_DEBUG_ASSERTE(offset <= size);
+	return record_written_size(format, size);
 }
 
-Table::Iterator&
-Table::Iterator::operator+=(
-	unsigned count
+// Morph supplied values and get the size of the record
+static unsigned
+record_init_size(
+	Data::Table::RecordFormat const& format,
+	Data::TableSchema::column_vector_type const& columns,
+	unsigned const num_values,
+	Data::ValueRef* const values
+) {
+	unsigned const num_columns = columns.size();
+	unsigned size = record_sparse_size(format);
+	unsigned index = 0;
+	for (; index < num_values; ++index) {
+		auto& value = values[index];
+		auto const type = columns[index].type;
+		bool const is_dynamic = type.type() == Data::ValueType::dynamic;
+		value.morph(type);
+		if (format.sparse_bits[index] == ~0u) {
+			size += max_ce(format.init_sizes[index], value_written_size(value, is_dynamic));
+		} else if (!value_initial(value, is_dynamic)) {
+			size += value_written_size(value, is_dynamic);
+		}
+	}
+	for (; index < num_columns; ++index) {
+		size += format.init_sizes[index];
+	}
+	return size;
+}
+
+static unsigned
+regular_field_offset(
+	Data::Table::RecordFormat const& format,
+	Data::TableSchema::column_vector_type const& columns,
+	Record const& record,
+	unsigned const index
 ) noexcept {
-	index += count;
-	if (index < table->m_num_records) {
-		auto const* chunk = &table->m_chunks[chunk_index];
-		while (inner_index + count > chunk->num_records) {
-			count -= chunk->num_records - inner_index;
-			++chunk_index;
-			inner_index = 0;
-			chunk = &table->m_chunks[chunk_index];
-			data_offset = chunk->offset_head();
+	unsigned offset = format.field_offsets[index];
+	if (offset != ~0u) {
+		return offset;
+	} else if (format.layout == Data::Table::Layout::indexed) {
+		return record_slots(format, record)[format.field_slots[index] - 1];
+	}
+	unsigned column = format.walk_column;
+	offset = format.field_offsets[column];
+	for (; column < index; ++column) {
+		if (format.sparse_bits[column] == ~0u) {
+			offset += value_read_size_whole(columns[column].type, record.data + offset);
 		}
-		Record record;
-		while (count--) {
-			record = record_read(chunk->data + data_offset);
-			data_offset += record_written_size(record);
-			DUCT_DEBUG_ASSERTE(data_offset <= chunk->size);
+	}
+	DUCT_DEBUG_ASSERTE(offset <= record.size);
+	return offset;
+}
+
+// End of the regular (non-sparse) fields
+static unsigned
+record_regular_size(
+	Data::Table::RecordFormat const& format,
+	Data::TableSchema::column_vector_type const& columns,
+	Record const& record
+) noexcept {
+	unsigned column;
+	if (format.layout == Data::Table::Layout::indexed) {
+		if (format.slot_columns.empty()) {
+			return format.fixed_size;
 		}
+		column = format.slot_columns.back();
+	} else if (format.walk_column == columns.size()) {
+		return format.fixed_size;
 	} else {
-		*this = table->end();
+		// NB: The walk column is regular
+		column = columns.size() - 1;
+		while (format.sparse_bits[column] != ~0u) {
+			--column;
+		}
 	}
-	return *this;
+	unsigned const offset = regular_field_offset(format, columns, record, column);
+	return offset + value_read_size_whole(columns[column].type, record.data + offset);
 }
 
-// class Table implementation
-
-#define HORD_SCOPE_CLASS Table
-
-void Table::free_chunks() {
-	for (auto& chunk : m_chunks) {
-		chunk_free(chunk);
+// Offset of a sparse field, or of where it would be inserted if it
+// is absent. The end of the record is located with the number of
+// sparse columns as the bit.
+static unsigned
+sparse_field_offset(
+	Data::Table::RecordFormat const& format,
+	Data::TableSchema::column_vector_type const& columns,
+	Record const& record,
+	unsigned const bit,
+	bool& present
+) noexcept {
+	unsigned offset = record_regular_size(format, columns, record);
+	auto const* const bits = record.data + offset;
+	offset += record_sparse_size(format);
+	for (unsigned prior = 0; prior < bit; ++prior) {
+		if (sparse_present(bits, prior)) {
+			offset += value_read_size_whole(
+				columns[format.sparse_columns[prior]].type,
+				record.data + offset
+			);
+		}
 	}
-	m_chunks.clear();
-	m_num_records = 0;
+	present = bit < format.sparse_columns.size() && sparse_present(bits, bit);
+	DUCT_DEBUG_ASSERTE(offset <= record.size);
+	return offset;
 }
 
-Table::~Table() noexcept {
-	free_chunks();
+// Offset of a field; ~0u if it is an absent sparse field
+static unsigned
+field_offset(
+	Data::Table::RecordFormat const& format,
+	Data::TableSchema const& schema,
+	Record const& record,
+	unsigned const index
+) noexcept {
+	unsigned const bit = format.sparse_bits[index];
+	if (bit == ~0u) {
+		return regular_field_offset(format, schema.columns(), record, index);
+	}
+	bool present;
+	unsigned const offset = sparse_field_offset(format, schema.columns(), record, bit, present);
+	return present ? offset : ~0u;
 }
 
-Table::Table(
-	Table&& other
+// Locate the fields of the first end columns in one pass
+static void
+record_field_offsets(
+	Data::Table::RecordFormat const& format,
+	Data::TableSchema::column_vector_type const& columns,
+	Record const& record,
+	unsigned const end,
+	unsigned* const offsets
 ) noexcept {
-	(*this) = std::move(other);
+	unsigned offset;
+	unsigned prev = ~0u;
+	for (unsigned index = 0; index < end; ++index) {
+		offset = format.field_offsets[index];
+		if (format.sparse_bits[index] != ~0u) {
+			continue;
+		} else if (offset != ~0u) {
+			// Constant
+		} else if (format.layout == Data::Table::Layout::indexed) {
+			offset = record_slots(format, record)[format.field_slots[index] - 1];
+		} else {
+			offset = offsets[prev] + value_read_size_whole(
+				columns[prev].type,
+				record.data + offsets[prev]
+			);
+		}
+		offsets[index] = offset;
+		prev = index;
+	}
+	if (format.sparse_columns.empty() || end <= format.sparse_columns.front()) {
+		return;
+	}
+	offset = record_regular_size(format, columns, record);
+	auto const* const bits = record.data + offset;
+	offset += record_sparse_size(format);
+	unsigned bit = 0;
+	for (unsigned const index : format.sparse_columns) {
+		if (end <= index) {
+			break;
+		} else if (sparse_present(bits, bit++)) {
+			offsets[index] = offset;
+			offset += value_read_size_whole(columns[index].type, record.data + offset);
+		} else {
+			offsets[index] = ~0u;
+		}
+	}
 }
 
-Table&
-Table::operator=(
-	Table&& other
+static unsigned
+record_data_size(
+	Data::Table::RecordFormat const& format,
+	Data::TableSchema const& schema,
+	Record const& record
 ) noexcept {
-	clear();
-	std::swap(m_num_records, other.m_num_records);
-	std::swap(m_schema, other.m_schema);
-	std::swap(m_chunks, other.m_chunks);
-	other.clear();
-	return *this;
+	if (format.sparse_columns.empty()) {
+		return record_regular_size(format, schema.columns(), record);
+	}
+	bool present;
+	return sparse_field_offset(
+		format, schema.columns(), record,
+		format.sparse_columns.size(), present
+	);
 }
 
-Table::Table(
-	Data::TableSchema const& schema
+static unsigned
+chunk_skip_records(
+	Data::Table::RecordFormat const& format,
+	Data::Table::Chunk const& chunk,
+	unsigned offset,
+	unsigned count
 ) noexcept {
-	replace_schema(schema);
+	if (format.stride) {
+		return offset + count * format.stride;
+	}
+	while (count--) {
+		offset += record_written_size(format, record_read(format, chunk.data + offset));
+		DUCT_DEBUG_ASSERTE(offset <= chunk.size);
+	}
+	return offset;
 }
 
 static void
-table_rewrite_records(
-	Data::Table::Chunk& chunk,
-	aux::vector<Record>& records,
-	unsigned const size,
-	Data::TableSchema::column_vector_type const& old_columns,
-	Data::TableSchema::column_vector_type const& new_columns,
-	aux::vector<unsigned>& old_offsets
+chunk_build_marks(
+	Data::Table::RecordFormat const& format,
+	Data::Table::Chunk& chunk
 ) {
-	if (chunk.size < size) {
-		chunk_allocate(chunk, size);
-	}
-	unsigned const num_old = old_columns.size();
-	auto const end_new = new_columns.cend();
-	unsigned offset = 0;
-	unsigned value_offset;
-	bool is_dynamic;
-	Data::ValueRef value;
-	for (auto const& record : records) {
-		value_offset = 0;
-		for (unsigned value_index = 0; value_index < num_old; ++value_index) {
-			old_offsets[value_index] = value_offset;
-			value_offset += value_read_size_whole(
-				old_columns[value_index].type,
-				record.data + value_offset
-			);
-		}
-		offset += record_write_size(record, chunk.data + offset);
-		value_offset = offset;
-		for (auto it = new_columns.cbegin(); it < end_new; ++it) {
-			is_dynamic = it->type.type() == Data::ValueType::dynamic;
-			if (it->index == ~0u) {
-				if (is_dynamic) {
-					value = {};
-				} else {
-					value = {it->type};
-				}
-			} else {
-				value = value_read(
-					old_columns[it->index].type,
-					record.data + old_offsets[it->index]
-				);
-				value.morph(it->type);
-			}
-			value_offset += value_write(value, chunk.data + value_offset, is_dynamic);
-		}
-		offset += record.size;
+	unsigned const stride = Data::Table::CHUNK_MARK_STRIDE;
+	chunk.marks.clear();
+	chunk.marks.reserve((chunk.num_records + stride - 1) / stride);
+	unsigned offset = chunk.offset_head();
+	for (unsigned index = 0; index < chunk.num_records; index += stride) {
+		chunk.marks.push_back(offset);
+		offset = chunk_skip_records(
+			format, chunk, offset,
+			min_ce(stride, chunk.num_records - index)
+		);
 	}
-	chunk_set_bounds(chunk, records.size(), 0, offset);
-	records.clear();
 }
 
-#define HORD_SCOPE_FUNC configure
-bool
-Table::configure(
-	Data::TableSchema const& schema
+static unsigned
+chunk_record_offset(
+	Data::Table::RecordFormat const& format,
+	Data::Table::Chunk& chunk,
+	unsigned const inner_index
+) {
+	unsigned const stride = Data::Table::CHUNK_MARK_STRIDE;
+	if (inner_index < stride || format.stride) {
+		return chunk_skip_records(format, chunk, chunk.offset_head(), inner_index);
+	} else if (chunk.marks.empty()) {
+		chunk_build_marks(format, chunk);
+	}
+	return chunk_skip_records(
+		format, chunk,
+		chunk.marks[inner_index / stride],
+		inner_index % stride
+	);
+}
+
+// Total size of record slack in a chunk
+static unsigned
+chunk_slack(
+	Data::Table::RecordFormat const& format,
+	Data::TableSchema const& schema,
+	Data::Table::Chunk const& chunk
+) noexcept {
+	unsigned slack = 0;
+	unsigned offset = chunk.offset_head();
+	Record record;
+	for (unsigned index = 0; index < chunk.num_records; ++index) {
+		record = record_read(format, chunk.data + offset);
+		slack += record.size - record_data_size(format, schema, record);
+		offset += record_written_size(format, record);
+	}
+	return slack;
+}
+
+// Trim record slack, moving records to the start of the chunk
+static void
+chunk_compact(
+	Data::Table::RecordFormat const& format,
+	Data::TableSchema const& schema,
+	Data::Table::Chunk& chunk
+) noexcept {
+	unsigned read_offset = chunk.offset_head();
+	unsigned write_offset = 0;
+	unsigned data_size;
+	unsigned size;
+	Record record;
+	for (unsigned index = 0; index < chunk.num_records; ++index) {
+		record = record_read(format, chunk.data + read_offset);
+		data_size = record_data_size(format, schema, record);
+		size = record_written_size(format, data_size);
+		read_offset += record_written_size(format, record);
+		// NB: Slots are relative to the record data, which moves with
+		// them. A compact header can only shrink, so the move is down.
+		std::memmove(
+			chunk.data + write_offset + size - data_size - format.slots_size,
+			record.data - format.slots_size,
+			format.slots_size + data_size
+		);
+		record_write_size(format, data_size, chunk.data + write_offset);
+		write_offset += size;
+	}
+	chunk.head = chunk.data;
+	chunk.tail = chunk.data + write_offset;
+	chunk.marks.clear();
+	chunk.dirty = false;
+}
+
+// NB: A columnar chunk holds one array per column, each with room for
+// (size / stride) values. The chunk's head is always its data and its
+// tail marks num_records * stride, so iterator offsets are virtual.
+
+inline static unsigned
+chunk_capacity(
+	Data::Table::RecordFormat const& format,
+	Data::Table::Chunk const& chunk
+) noexcept {
+	return chunk.size / format.stride;
+}
+
+inline static std::uint8_t*
+column_data(
+	Data::Table::RecordFormat const& format,
+	Data::Table::Chunk const& chunk,
+	unsigned const index
+) noexcept {
+	return chunk.data + chunk_capacity(format, chunk) * format.field_offsets[index];
+}
+
+inline static void
+chunk_columns_allocate(
+	Data::Table::RecordFormat const& format,
+	Data::Table::Chunk& chunk,
+	unsigned const capacity
+) noexcept {
+	chunk_allocate(
+		chunk,
+		max_ce(capacity, max_ce(CHUNK_SIZE / format.stride, 1u)) * format.stride
+	);
+}
+
+inline static void
+chunk_columns_set_count(
+	Data::Table::RecordFormat const& format,
+	Data::Table::Chunk& chunk,
+	unsigned const num_records
+) noexcept {
+	DUCT_DEBUG_ASSERTE(num_records <= chunk_capacity(format, chunk));
+	chunk.num_records = num_records;
+	chunk.head = chunk.data;
+	chunk.tail = chunk.data + num_records * format.stride;
+}
+
+static void
+chunk_columns_copy(
+	Data::Table::RecordFormat const& format,
+	Data::TableSchema::column_vector_type const& columns,
+	Data::Table::Chunk const& source,
+	unsigned const source_index,
+	Data::Table::Chunk& destination,
+	unsigned const destination_index,
+	unsigned const count
+) noexcept {
+	unsigned const num_columns = columns.size();
+	unsigned size;
+	for (unsigned index = 0; index < num_columns; ++index) {
+		size = column_fixed_size(columns[index].type);
+		std::memcpy(
+			column_data(format, destination, index) + destination_index * size,
+			column_data(format, source, index) + source_index * size,
+			count * size
+		);
+	}
+}
+
+// Open (or close) a gap at inner_index in every column
+static void
+chunk_columns_shift(
+	Data::Table::RecordFormat const& format,
+	Data::TableSchema::column_vector_type const& columns,
+	Data::Table::Chunk& chunk,
+	unsigned const inner_index,
+	bool const open
+) noexcept {
+	unsigned const num_columns = columns.size();
+	unsigned const count = chunk.num_records - inner_index - (open ? 0 : 1);
+	unsigned size;
+	std::uint8_t* data;
+	for (unsigned index = 0; index < num_columns; ++index) {
+		size = column_fixed_size(columns[index].type);
+		data = column_data(format, chunk, index) + inner_index * size;
+		if (open) {
+			std::memmove(data + size, data, count * size);
+		} else {
+			std::memmove(data, data + size, count * size);
+		}
+	}
+}
+
+static void
+chunk_columns_write(
+	Data::Table::RecordFormat const& format,
+	Data::TableSchema::column_vector_type const& columns,
+	Data::Table::Chunk& chunk,
+	unsigned const inner_index,
+	unsigned const num_values,
+	Data::ValueRef const* const values
+) noexcept {
+	unsigned const num_columns = columns.size();
+	for (unsigned index = 0; index < num_columns; ++index) {
+		auto const type = columns[index].type;
+		value_write(
+			index < num_values ? values[index] : Data::ValueRef{type},
+			column_data(format, chunk, index) + inner_index * column_fixed_size(type),
+			false
+		);
+	}
+}
+
+// Convert a chunk between row-major and column-major
+static void
+chunk_transpose(
+	Data::Table::RecordFormat const& format,
+	Data::TableSchema::column_vector_type const& columns,
+	Data::Table::Chunk& chunk,
+	bool const to_columns
+) {
+	unsigned const stride = format.stride;
+	unsigned const num_records = chunk.num_records;
+	unsigned const num_columns = columns.size();
+	Data::Table::Chunk result{};
+	result.allocator = chunk.allocator;
+	result.version = chunk.version;
+	if (to_columns) {
+		chunk_columns_allocate(format, result, num_records);
+	} else {
+		chunk_allocate(result, max_ce(num_records * stride, CHUNK_SIZE));
+	}
+	unsigned size;
+	std::uint8_t const* source;
+	std::uint8_t* destination;
+	unsigned source_step;
+	unsigned destination_step;
+	for (unsigned index = 0; index < num_columns; ++index) {
+		size = column_fixed_size(columns[index].type);
+		if (to_columns) {
+			source = chunk.head + format.field_offsets[index];
+			source_step = stride;
+			destination = column_data(format, result, index);
+			destination_step = size;
+		} else {
+			source = column_data(format, chunk, index);
+			source_step = size;
+			destination = result.data + format.field_offsets[index];
+			destination_step = stride;
+		}
+		for (unsigned inner = 0; inner < num_records; ++inner) {
+			std::memcpy(destination, source, size);
+			source += source_step;
+			destination += destination_step;
+		}
+	}
+	result.num_records = num_records;
+	result.tail = result.data + num_records * stride;
+	chunk_free(chunk);
+	chunk = std::move(result);
+}
+
+// Take another reference to a chunk's data
+static Data::Table::Chunk
+chunk_share(
+	Data::Table::Chunk const& chunk
+) noexcept {
+	// NB: The count is allocated with the data, so sharing from a
+	// const table only increments it
+	if (chunk.refs) {
+		chunk.refs->fetch_add(1, std::memory_order_relaxed);
+	}
+	return chunk;
+}
+
+inline static bool
+chunk_shared(
+	Data::Table::Chunk const& chunk
+) noexcept {
+	// NB: Borrowed data is read-only
+	return
+		chunk.borrowed ||
+		(chunk.refs && 1 < chunk.refs->load(std::memory_order_acquire))
+	;
+}
+
+// Make a chunk's data exclusive before modifying it. Record offsets
+// are retained.
+static void
+chunk_unshare(
+	Data::Table::RecordFormat const& format,
+	Data::TableSchema::column_vector_type const& columns,
+	Data::Table::Chunk& chunk
+) noexcept {
+	if (!chunk_shared(chunk)) {
+		return;
+	}
+	Data::Table::Chunk copy{};
+	copy.allocator = chunk.allocator;
+	copy.version = chunk.version;
+	if (format.columnar) {
+		chunk_columns_allocate(format, copy, chunk_capacity(format, chunk));
+		chunk_columns_copy(format, columns, chunk, 0, copy, 0, chunk.num_records);
+		chunk_columns_set_count(format, copy, chunk.num_records);
+	} else {
+		// NB: Borrowed data has no slack
+		chunk_allocate(copy, chunk.borrowed ? max_ce(chunk.size, CHUNK_SIZE) : chunk.size);
+		copy.num_records = chunk.num_records;
+		copy.head = copy.data + chunk.offset_head();
+		copy.tail = copy.data + chunk.offset_tail();
+		std::memcpy(copy.head, chunk.head, chunk.space_used());
+	}
+	copy.dirty = chunk.dirty;
+	copy.marks = std::move(chunk.marks);
+	copy.zones = std::move(chunk.zones);
+	copy.blooms = std::move(chunk.blooms);
+	chunk_free(chunk);
+	chunk = std::move(copy);
+}
+
+// NB: Versions are contiguous and chunks of the current version have
+// none
+inline static Data::Table::SchemaVersion const*
+chunk_version(
+	Data::Table::version_vector_type const& versions,
+	Data::Table::Chunk const& chunk
+) noexcept {
+	if (
+		versions.empty() ||
+		chunk.version - versions.front().version >= versions.size()
+	) {
+		return nullptr;
+	}
+	return &versions[chunk.version - versions.front().version];
+}
+
+inline static Data::Table::RecordFormat const&
+chunk_format(
+	Data::Table::RecordFormat const& format,
+	Data::Table::version_vector_type const& versions,
+	Data::Table::Chunk const& chunk
+) noexcept {
+	auto const* const version = chunk_version(versions, chunk);
+	return version ? version->format : format;
+}
+
+static HashValue
+value_hash(
+	Data::ValueRef const& value
+) noexcept {
+	HashCombiner hc;
+	Data::TypeValue const type_value = value.type.value();
+	hc.add(reinterpret_cast<char const*>(&type_value), sizeof(Data::TypeValue));
+	auto const& vp = Data::type_properties(value.type);
+	if (value.type.type() == Data::ValueType::null) {
+		// Do nothing
+	} else if (vp.flags & Data::VTP_DYNAMIC_SIZE) {
+		hc.add(value.data.string, value.size);
+	} else {
+		hc.add(
+			reinterpret_cast<char const*>(&value.data),
+			vp.fixed_size[enum_cast(value.type.size())]
+		);
+	}
+	return hc.value();
+}
+
+// Whether a column type can be ordered-indexed
+static bool
+index_ordered(
+	Data::Type const type
+) noexcept {
+	switch (type.type()) {
+	case Data::ValueType::integer:
+	case Data::ValueType::decimal:
+	case Data::ValueType::object_id:
+		return true;
+	default:
+		return false;
+	}
+}
+
+// Key that orders values of an ordered-indexable type as unsigned integers
+static std::uint64_t
+value_order_key(
+	Data::ValueRef const& value
+) noexcept {
+	std::uint64_t const sign_bit = std::uint64_t{1} << 63;
+	switch (value.type.type()) {
+	case Data::ValueType::integer:
+		if (enum_cast(value.type.flags() & Data::ValueFlag::integer_signed)) {
+			return static_cast<std::uint64_t>(value.integer_signed()) ^ sign_bit;
+		}
+		return value.integer_unsigned();
+
+	case Data::ValueType::decimal: {
+		double const decimal = value.decimal();
+		std::uint64_t bits;
+		std::memcpy(&bits, &decimal, sizeof(bits));
+		return (bits & sign_bit) ? ~bits : bits | sign_bit;
+	}
+
+	case Data::ValueType::object_id:
+		return value.data.object_id.value();
+
+	default:
+		return 0;
+	}
+}
+
+static HashValue
+index_key(
+	Data::Table::HashIndex const& /*index*/,
+	Data::ValueRef const& value
+) noexcept {
+	return value_hash(value);
+}
+
+static std::uint64_t
+index_key(
+	Data::Table::OrderedIndex const& /*index*/,
+	Data::ValueRef const& value
+) noexcept {
+	return value_order_key(value);
+}
+
+static bool
+index_valid(
+	Data::Table::HashIndex const& /*index*/,
+	Data::Type const /*type*/
+) noexcept {
+	return true;
+}
+
+static bool
+index_valid(
+	Data::Table::OrderedIndex const& /*index*/,
+	Data::Type const type
+) noexcept {
+	return index_ordered(type);
+}
+
+// Treap priority of a record ID (a bijective mix, so IDs never tie)
+static unsigned
+record_id_priority(
+	unsigned id
+) noexcept {
+	id ^= id >> 16;
+	id *= 0x85EBCA6Bu;
+	id ^= id >> 13;
+	id *= 0xC2B2AE35u;
+	id ^= id >> 16;
+	return id;
+}
+
+static unsigned
+record_ids_size(
+	Data::Table::RecordIds const& ids,
+	unsigned const id
+) noexcept {
+	return id == ~0u ? 0 : ids.nodes[id].size;
+}
+
+static void
+record_ids_update(
+	Data::Table::RecordIds& ids,
+	unsigned const id
+) noexcept {
+	auto& node = ids.nodes[id];
+	node.size = 1 + record_ids_size(ids, node.left) + record_ids_size(ids, node.right);
+	if (node.left != ~0u) {
+		ids.nodes[node.left].parent = id;
+	}
+	if (node.right != ~0u) {
+		ids.nodes[node.right].parent = id;
+	}
+}
+
+// Split a subtree into its first count records and the rest
+static void
+record_ids_split(
+	Data::Table::RecordIds& ids,
+	unsigned const id,
+	unsigned const count,
+	unsigned& left,
+	unsigned& right
+) noexcept {
+	if (id == ~0u) {
+		left = ~0u;
+		right = ~0u;
+		return;
+	}
+	auto& node = ids.nodes[id];
+	unsigned const left_size = record_ids_size(ids, node.left);
+	if (count <= left_size) {
+		record_ids_split(ids, node.left, count, left, node.left);
+		right = id;
+	} else {
+		record_ids_split(ids, node.right, count - left_size - 1, node.right, right);
+		left = id;
+	}
+	record_ids_update(ids, id);
+}
+
+static unsigned
+record_ids_merge(
+	Data::Table::RecordIds& ids,
+	unsigned const left,
+	unsigned const right
+) noexcept {
+	if (left == ~0u) {
+		return right;
+	} else if (right == ~0u) {
+		return left;
+	} else if (record_id_priority(left) > record_id_priority(right)) {
+		unsigned const child = record_ids_merge(ids, ids.nodes[left].right, right);
+		ids.nodes[left].right = child;
+		record_ids_update(ids, left);
+		return left;
+	} else {
+		unsigned const child = record_ids_merge(ids, left, ids.nodes[right].left);
+		ids.nodes[right].left = child;
+		record_ids_update(ids, right);
+		return right;
+	}
+}
+
+static void
+record_ids_fix(
+	Data::Table::RecordIds& ids,
+	unsigned const id
+) noexcept {
+	if (id != ~0u) {
+		record_ids_fix(ids, ids.nodes[id].left);
+		record_ids_fix(ids, ids.nodes[id].right);
+		record_ids_update(ids, id);
+	}
+}
+
+// Rebuild the tree with IDs in the given order (IDs must be allocated)
+static void
+record_ids_assign(
+	Data::Table::RecordIds& ids,
+	aux::vector<unsigned> const& order
+) {
+	// NB: Builds the treap as a Cartesian tree in linear time
+	aux::vector<unsigned> spine{};
+	for (auto const id : order) {
+		unsigned last = ~0u;
+		while (
+			!spine.empty() &&
+			record_id_priority(spine.back()) < record_id_priority(id)
+		) {
+			last = spine.back();
+			spine.pop_back();
+		}
+		ids.nodes[id] = {~0u, last, ~0u, 1};
+		if (!spine.empty()) {
+			ids.nodes[spine.back()].right = id;
+		}
+		spine.push_back(id);
+	}
+	ids.root = spine.empty() ? ~0u : spine.front();
+	record_ids_fix(ids, ids.root);
+	if (ids.root != ~0u) {
+		ids.nodes[ids.root].parent = ~0u;
+	}
+}
+
+static void
+record_ids_collect(
+	Data::Table::RecordIds const& ids,
+	unsigned const id,
+	aux::vector<unsigned>& order
+) {
+	if (id != ~0u) {
+		record_ids_collect(ids, ids.nodes[id].left, order);
+		order.push_back(id);
+		record_ids_collect(ids, ids.nodes[id].right, order);
+	}
+}
+
+// Reset to IDs equal to record indices
+static void
+record_ids_build(
+	Data::Table::RecordIds& ids,
+	unsigned const num_records
+) {
+	ids.nodes.resize(num_records);
+	ids.nodes.shrink_to_fit();
+	ids.free.clear();
+	aux::vector<unsigned> order(num_records);
+	for (unsigned index = 0; index < num_records; ++index) {
+		order[index] = index;
+	}
+	record_ids_assign(ids, order);
+}
+
+static unsigned
+record_ids_insert(
+	Data::Table::RecordIds& ids,
+	unsigned const position
+) {
+	unsigned id;
+	if (ids.free.empty()) {
+		id = ids.nodes.size();
+		ids.nodes.push_back({~0u, ~0u, ~0u, 1});
+	} else {
+		id = ids.free.back();
+		ids.free.pop_back();
+		ids.nodes[id] = {~0u, ~0u, ~0u, 1};
+	}
+	unsigned left;
+	unsigned right;
+	record_ids_split(ids, ids.root, position, left, right);
+	ids.root = record_ids_merge(ids, record_ids_merge(ids, left, id), right);
+	ids.nodes[ids.root].parent = ~0u;
+	return id;
+}
+
+static void
+record_ids_remove(
+	Data::Table::RecordIds& ids,
+	unsigned const id
+) {
+	auto const node = ids.nodes[id];
+	unsigned const child = record_ids_merge(ids, node.left, node.right);
+	if (child != ~0u) {
+		ids.nodes[child].parent = node.parent;
+	}
+	if (node.parent == ~0u) {
+		ids.root = child;
+	} else {
+		auto& parent = ids.nodes[node.parent];
+		(parent.left == id ? parent.left : parent.right) = child;
+		for (unsigned ancestor = node.parent; ancestor != ~0u;) {
+			--ids.nodes[ancestor].size;
+			ancestor = ids.nodes[ancestor].parent;
+		}
+	}
+	ids.free.push_back(id);
+}
+
+static unsigned
+record_ids_at(
+	Data::Table::RecordIds const& ids,
+	unsigned position
+) noexcept {
+	unsigned id = ids.root;
+	while (true) {
+		auto const& node = ids.nodes[id];
+		unsigned const left_size = record_ids_size(ids, node.left);
+		if (position < left_size) {
+			id = node.left;
+		} else if (position == left_size) {
+			return id;
+		} else {
+			position -= left_size + 1;
+			id = node.right;
+		}
+	}
+}
+
+static unsigned
+record_ids_position(
+	Data::Table::RecordIds const& ids,
+	unsigned id
+) noexcept {
+	unsigned position = record_ids_size(ids, ids.nodes[id].left);
+	for (unsigned parent = ids.nodes[id].parent; parent != ~0u;) {
+		auto const& node = ids.nodes[parent];
+		if (node.right == id) {
+			position += record_ids_size(ids, node.left) + 1;
+		}
+		id = parent;
+		parent = node.parent;
+	}
+	return position;
+}
+
+template<class I, class K>
+static void
+index_erase(
+	I& index,
+	K const key,
+	unsigned const record_index
+) noexcept {
+	auto const range = index.records.equal_range(key);
+	for (auto it = range.first; it != range.second; ++it) {
+		if (it->second == record_index) {
+			index.records.erase(it);
+			return;
+		}
+	}
+	DUCT_DEBUG_ASSERTE(false);
+}
+
+template<class I>
+static void
+index_insert(
+	I& index,
+	Data::Table& table,
+	Data::Table::Iterator const& it,
+	unsigned const id
+) noexcept {
+	if (index.column == ~0u) {
+		return;
+	}
+	index.records.emplace(index_key(index, table.get_field(it, index.column)), id);
+}
+
+template<class I>
+static void
+index_remove_entry(
+	I& index,
+	Data::Table& table,
+	Data::Table::Iterator const& it,
+	unsigned const id
+) noexcept {
+	if (index.column == ~0u) {
+		return;
+	}
+	index_erase(index, index_key(index, table.get_field(it, index.column)), id);
+}
+
+template<class I>
+static void
+index_update(
+	I& index,
+	Data::Table& table,
+	Data::Table::RecordIds const& ids,
+	Data::Table::Iterator const& it,
+	unsigned const column_index,
+	Data::ValueRef const& new_value
+) noexcept {
+	if (column_index != index.column) {
+		return;
+	}
+	unsigned const id = record_ids_at(ids, it.index);
+	index_erase(index, index_key(index, table.get_field(it, column_index)), id);
+	index.records.emplace(index_key(index, new_value), id);
+}
+
+// NB: Record IDs must be equal to record indices
+template<class I>
+static void
+index_rebuild_records(
+	I& index,
+	Data::Table& table
+) noexcept {
+	index.records.clear();
+	if (
+		index.column >= table.num_columns() ||
+		!index_valid(index, table.column(index.column).type)
+	) {
+		index.column = ~0u;
+		return;
+	}
+	for (auto it = table.begin(); it.can_advance(); ++it) {
+		index.records.emplace(index_key(index, table.get_field(it, index.column)), it.index);
+	}
+}
+
+// Exact equality (ValueRef::operator==() is approximate for decimals)
+static bool
+value_same(
+	Data::ValueRef const& x,
+	Data::ValueRef const& y
+) noexcept {
+	if (x.type.value() != y.type.value()) {
+		return false;
+	}
+	auto const& vp = Data::type_properties(x.type);
+	if (x.type.type() == Data::ValueType::null) {
+		return true;
+	} else if (vp.flags & Data::VTP_DYNAMIC_SIZE) {
+		return
+			x.size == y.size &&
+			std::memcmp(x.data.string, y.data.string, x.size) == 0
+		;
+	}
+	return std::memcmp(
+		&x.data, &y.data,
+		vp.fixed_size[enum_cast(x.type.size())]
+	) == 0;
+}
+
+inline static bool
+type_coded(
+	Data::Type const type
+) noexcept {
+	return
+		type.type() == Data::ValueType::string &&
+		enum_cast(type.flags() & Data::ValueFlag::string_dictionary)
+	;
+}
+
+// Type of the values of a column as they are read
+inline static Data::Type
+type_decoded(
+	Data::Type const type
+) noexcept {
+	return type_coded(type) ? Data::Type{Data::ValueType::string, type.size()} : type;
+}
+
+// Whether a column type is bounded by chunk zones
+inline static bool
+zone_column(
+	Data::Type const type
+) noexcept {
+	return
+		index_ordered(type) ||
+		(type.type() == Data::ValueType::string && !type_coded(type))
+	;
+}
+
+// Bound key of a value of a zoned column
+static std::uint64_t
+zone_key(
+	Data::ValueRef const& value
+) noexcept {
+	if (value.type.type() == Data::ValueType::string) {
+		return value.size;
+	} else if (
+		value.type.type() == Data::ValueType::decimal &&
+		std::fpclassify(value.decimal()) == FP_ZERO
+	) {
+		// NB: Negative zero equals zero
+		return value_order_key(Data::ValueRef{0.0});
+	}
+	return value_order_key(value);
+}
+
+inline static void
+zone_add(
+	Data::Table::Zone& zone,
+	std::uint64_t const key
+) noexcept {
+	zone.min = min_ce(zone.min, key);
+	zone.max = max_ce(zone.max, key);
+}
+
+// Widen the zones of a chunk holding num_records records by the values
+// of a record added to it (absent values are initial)
+static void
+chunk_zones_add(
+	Data::TableSchema::column_vector_type const& columns,
+	Data::Table::Chunk& chunk,
+	unsigned const num_records,
+	unsigned const num_values,
+	Data::ValueRef const* const values
+) {
+	if (num_records == 0) {
+		// NB: Bounds of an empty chunk are known
+		chunk.zones.assign(columns.size(), {});
+	} else if (chunk.zones.empty()) {
+		return;
+	}
+	for (unsigned index = 0; index < columns.size(); ++index) {
+		auto const type = columns[index].type;
+		if (zone_column(type)) {
+			zone_add(
+				chunk.zones[index],
+				zone_key(index < num_values ? values[index] : Data::ValueRef{type})
+			);
+		}
+	}
+}
+
+// Visit a column of a chunk as runs of (data, step, count, first
+// record index). Columnar and fixed-stride chunks are visited as whole
+// runs; other records are visited individually.
+template<class F>
+static void
+chunk_visit_column(
+	Data::Table::RecordFormat const& format,
+	Data::TableSchema const& schema,
+	Data::Table::Chunk const& chunk,
+	unsigned const column,
+	unsigned const first_index,
+	F&& visit
+) {
+	if (column == ~0u) {
+		// Appended since the chunk was written
+		for (unsigned index = 0; index < chunk.num_records; ++index) {
+			visit(INIT_VALUE_DATA, 0u, 1u, first_index + index);
+		}
+	} else if (format.columnar) {
+		visit(
+			column_data(format, chunk, column),
+			column_fixed_size(schema.column(column).type),
+			chunk.num_records, first_index
+		);
+	} else if (format.stride) {
+		visit(
+			chunk.head + format.field_offsets[column],
+			format.stride, chunk.num_records, first_index
+		);
+	} else {
+		unsigned offset = chunk.offset_head();
+		Record record;
+		unsigned field;
+		for (unsigned index = 0; index < chunk.num_records; ++index) {
+			record = record_read(format, chunk.data + offset);
+			field = field_offset(format, schema, record, column);
+			visit(
+				field != ~0u ? record.data + field : INIT_VALUE_DATA,
+				0u, 1u, first_index + index
+			);
+			offset += record_written_size(format, record);
+		}
+	}
+}
+
+// Rebuild the zones of a chunk from its records
+static void
+chunk_zones_build(
+	Data::Table::RecordFormat const& format,
+	Data::TableSchema const& schema,
+	Data::Table::Chunk& chunk
+) {
+	chunk.zones.assign(schema.num_columns(), {});
+	for (unsigned column = 0; column < schema.num_columns(); ++column) {
+		auto const type = schema.column(column).type;
+		if (!zone_column(type)) {
+			continue;
+		}
+		auto& zone = chunk.zones[column];
+		chunk_visit_column(
+			format, schema, chunk, column, 0,
+			[&zone, type](
+				std::uint8_t const* const data,
+				unsigned const step,
+				unsigned const count,
+				unsigned const /*first_index*/
+			) {
+				for (unsigned index = 0; index < count; ++index) {
+					zone_add(zone, zone_key(value_read(type, data + index * step)));
+				}
+			}
+		);
+	}
+}
+
+// Whether a column type can have chunk filters
+inline static bool
+bloom_valid(
+	Data::Type const type
+) noexcept {
+	return
+		type.type() == Data::ValueType::object_id ||
+		(type.type() == Data::ValueType::string && !type_coded(type))
+	;
+}
+
+// Filter hash of a value of a filtered column
+static std::uint64_t
+bloom_hash(
+	Data::ValueRef const& value
+) noexcept {
+	HashCombiner hc;
+	if (value.type.type() == Data::ValueType::string) {
+		hc.add(value.data.string, value.size);
+	} else {
+		auto const id = value.data.object_id.value();
+		hc.add(reinterpret_cast<char const*>(&id), sizeof(id));
+	}
+	// NB: Filter bits are taken from both halves of the hash, so the
+	// FNV-1a hash is mixed to make each depend on every byte
+	std::uint64_t hash = hc.value();
+	hash ^= hash >> 33;
+	hash *= 0xff51afd7ed558ccdull;
+	hash ^= hash >> 33;
+	hash *= 0xc4ceb9fe1a85ec53ull;
+	hash ^= hash >> 33;
+	return hash;
+}
+
+// Whether a filter may hold a value. Bits of a hash are taken by
+// double hashing.
+static bool
+bloom_test(
+	Data::Table::Bloom const& bloom,
+	std::uint64_t hash
+) noexcept {
+	if (bloom.bits.empty()) {
+		return true;
+	}
+	std::uint64_t const num_bits = bloom.bits.size() * 64;
+	std::uint64_t const step = (hash >> 32) | 1;
+	std::uint64_t bit;
+	for (unsigned index = 0; index < Data::Table::BLOOM_NUM_HASHES; ++index) {
+		bit = hash % num_bits;
+		if (!((bloom.bits[bit >> 6] >> (bit & 63)) & 1)) {
+			return false;
+		}
+		hash += step;
+	}
+	return true;
+}
+
+static void
+bloom_set(
+	Data::Table::Bloom& bloom,
+	std::uint64_t hash
+) noexcept {
+	std::uint64_t const num_bits = bloom.bits.size() * 64;
+	std::uint64_t const step = (hash >> 32) | 1;
+	std::uint64_t bit;
+	for (unsigned index = 0; index < Data::Table::BLOOM_NUM_HASHES; ++index) {
+		bit = hash % num_bits;
+		bloom.bits[bit >> 6] |= std::uint64_t{1} << (bit & 63);
+		hash += step;
+	}
+}
+
+// Add a value to a filter. A filter holding twice the values it was
+// sized for is dropped to be rebuilt by compaction.
+static void
+bloom_add(
+	Data::Table::Bloom& bloom,
+	std::uint64_t const hash
+) noexcept {
+	if (bloom.bits.empty()) {
+		return;
+	} else if (
+		2 * 64 * bloom.bits.size()
+		< ++bloom.num_values * Data::Table::BLOOM_BITS_PER_VALUE
+	) {
+		bloom = {};
+		return;
+	}
+	bloom_set(bloom, hash);
+}
+
+// Add the values of a record added to a chunk holding num_records
+// records to its filters (absent values are initial)
+static void
+chunk_blooms_add(
+	Data::TableSchema::column_vector_type const& columns,
+	Data::Table::Chunk& chunk,
+	unsigned const num_records,
+	unsigned const num_values,
+	Data::ValueRef const* const values
+) noexcept {
+	if (num_records == 0) {
+		// NB: Filters of an emptied chunk may be of another version
+		chunk.blooms.clear();
+		return;
+	}
+	for (unsigned index = 0; index < chunk.blooms.size(); ++index) {
+		auto& bloom = chunk.blooms[index];
+		if (!bloom.bits.empty()) {
+			bloom_add(bloom, bloom_hash(
+				index < num_values ? values[index] : Data::ValueRef{columns[index].type}
+			));
+		}
+	}
+}
+
+// Build the missing filters of a chunk for columns
+static void
+chunk_blooms_build(
+	Data::Table::RecordFormat const& format,
+	Data::TableSchema const& schema,
+	aux::vector<unsigned> const& columns,
+	Data::Table::Chunk& chunk
+) {
+	chunk.blooms.resize(schema.num_columns());
+	unsigned const num_words = max_ce(
+		1u, (chunk.num_records * Data::Table::BLOOM_BITS_PER_VALUE + 63) / 64
+	);
+	for (unsigned const column : columns) {
+		auto& bloom = chunk.blooms[column];
+		if (!bloom.bits.empty()) {
+			continue;
+		}
+		auto const type = schema.column(column).type;
+		bloom.num_values = chunk.num_records;
+		bloom.bits.assign(num_words, 0);
+		chunk_visit_column(
+			format, schema, chunk, column, 0,
+			[&bloom, type](
+				std::uint8_t const* const data,
+				unsigned const step,
+				unsigned const count,
+				unsigned const /*first_index*/
+			) {
+				for (unsigned index = 0; index < count; ++index) {
+					bloom_set(bloom, bloom_hash(value_read(type, data + index * step)));
+				}
+			}
+		);
+	}
+}
+
+inline static unsigned
+value_code(
+	Data::ValueRef const& value
+) noexcept {
+	switch (Data::size_meta(value.type.size())) {
+	case 1: return value.data.u8;
+	case 2: return value.data.u16;
+	default: return value.data.u32;
+	}
+}
+
+inline static Data::ValueRef
+value_coded(
+	Data::Type const type,
+	unsigned const code
+) noexcept {
+	Data::ValueRef value{};
+	value.type = type;
+	switch (Data::size_meta(type.size())) {
+	case 1: value.data.u8 = static_cast<std::uint8_t>(code); break;
+	case 2: value.data.u16 = static_cast<std::uint16_t>(code); break;
+	default: value.data.u32 = code; break;
+	}
+	return value;
+}
+
+static HashValue
+dictionary_hash(
+	Data::ValueRef const& value
+) noexcept {
+	HashCombiner hc;
+	hc.add(value.data.string, value.size);
+	return hc.value();
+}
+
+// Reset to the empty string, which is code 0 so that initial field data
+// decodes to it
+static void
+dictionary_reset(
+	Data::Table::Dictionary& dictionary
+) {
+	dictionary.values.assign(1, String{});
+	dictionary.codes.clear();
+}
+
+// Build dictionaries for columns (none if no column is coded)
+static void
+dictionaries_build(
+	Data::Table::dictionary_vector_type& dictionaries,
+	Data::TableSchema::column_vector_type const& columns
+) {
+	dictionaries.clear();
+	for (unsigned index = 0; index < columns.size(); ++index) {
+		if (type_coded(columns[index].type)) {
+			dictionaries.resize(columns.size());
+			dictionary_reset(dictionaries[index]);
+		}
+	}
+}
+
+// Find the code of a decoded value (~0u if it has none)
+static unsigned
+dictionary_find(
+	Data::Table::Dictionary const& dictionary,
+	Data::ValueRef const& value
+) noexcept {
+	if (value.size == 0) {
+		return 0;
+	}
+	auto const range = dictionary.codes.equal_range(dictionary_hash(value));
+	for (auto it = range.first; it != range.second; ++it) {
+		auto const& string = dictionary.values[it->second];
+		if (
+			string.size() == value.size &&
+			std::memcmp(string.data(), value.data.string, value.size) == 0
+		) {
+			return it->second;
+		}
+	}
+	return ~0u;
+}
+
+// Find or add the code of a decoded value (~0u if the dictionary is
+// full)
+static unsigned
+dictionary_add(
+	Data::Table::Dictionary& dictionary,
+	Data::Type const type,
+	Data::ValueRef const& value
+) {
+	unsigned code = dictionary_find(dictionary, value);
+	if (code != ~0u) {
+		return code;
+	}
+	code = dictionary.values.size();
+	if (code > (~0u >> (32 - 8 * Data::size_meta(type.size())))) {
+		return ~0u;
+	}
+	dictionary.values.emplace_back(value.data.string, value.size);
+	dictionary.codes.emplace(dictionary_hash(value), code);
+	return code;
+}
+
+static Data::ValueRef
+dictionary_decode(
+	Data::Table::Dictionary const& dictionary,
+	Data::ValueRef const& value
+) noexcept {
+	unsigned const code = value_code(value);
+	DUCT_DEBUG_ASSERTE(code < dictionary.values.size());
+	auto const& string = dictionary.values[code < dictionary.values.size() ? code : 0];
+	Data::ValueRef decoded{string.data(), static_cast<unsigned>(string.size())};
+	decoded.type = type_decoded(value.type);
+	return decoded;
+}
+
+} // anonymous namespace
+
+// class Table::ChunkTree implementation
+
+namespace {
+
+using ChunkNode = Data::Table::ChunkTree::Node;
+
+inline static unsigned
+node_height(
+	ChunkNode const* const node
+) noexcept {
+	return node ? node->height : 0;
+}
+
+inline static unsigned
+node_num_chunks(
+	ChunkNode const* const node
+) noexcept {
+	return node ? node->num_chunks : 0;
+}
+
+inline static unsigned
+node_num_records(
+	ChunkNode const* const node
+) noexcept {
+	return node ? node->num_records : 0;
+}
+
+inline static void
+node_update(
+	ChunkNode* const node
+) noexcept {
+	node->height = 1 + max_ce(node_height(node->left), node_height(node->right));
+	node->num_chunks = 1 + node_num_chunks(node->left) + node_num_chunks(node->right);
+	node->num_records
+		= node->chunk.num_records
+		+ node_num_records(node->left)
+		+ node_num_records(node->right)
+	;
+}
+
+// Rotate the right child (or left, if !left) into the node's position
+static ChunkNode*
+node_rotate(
+	ChunkNode* const node,
+	bool const left
+) noexcept {
+	ChunkNode* const pivot = left ? node->right : node->left;
+	ChunkNode* const inner = left ? pivot->left : pivot->right;
+	if (left) {
+		node->right = inner;
+		pivot->left = node;
+	} else {
+		node->left = inner;
+		pivot->right = node;
+	}
+	if (inner) {
+		inner->parent = node;
+	}
+	pivot->parent = node->parent;
+	node->parent = pivot;
+	node_update(node);
+	node_update(pivot);
+	return pivot;
+}
+
+static ChunkNode*
+node_rebalance(
+	ChunkNode* node
+) noexcept {
+	node_update(node);
+	unsigned const height_left = node_height(node->left);
+	unsigned const height_right = node_height(node->right);
+	if (height_left > height_right + 1) {
+		if (node_height(node->left->left) < node_height(node->left->right)) {
+			node->left = node_rotate(node->left, true);
+		}
+		node = node_rotate(node, false);
+	} else if (height_right > height_left + 1) {
+		if (node_height(node->right->right) < node_height(node->right->left)) {
+			node->right = node_rotate(node->right, false);
+		}
+		node = node_rotate(node, true);
+	}
+	return node;
+}
+
+} // anonymous namespace
+
+Table::ChunkTree::Node*
+Table::ChunkTree::first(
+	Node* node
+) noexcept {
+	while (node->left) {
+		node = node->left;
+	}
+	return node;
+}
+
+Table::ChunkTree::Node*
+Table::ChunkTree::last(
+	Node* node
+) noexcept {
+	while (node->right) {
+		node = node->right;
+	}
+	return node;
+}
+
+Table::ChunkTree::Node const*
+Table::ChunkTree::next_node(
+	Node const* node
+) noexcept {
+	if (node->right) {
+		return first(node->right);
+	}
+	while (node->parent && node->parent->right == node) {
+		node = node->parent;
+	}
+	return node->parent;
+}
+
+Table::ChunkTree::Node*
+Table::ChunkTree::select(
+	unsigned index
+) const noexcept {
+	DUCT_DEBUG_ASSERTE(index < size());
+	Node* node = m_root;
+	unsigned num_left;
+	for (;;) {
+		num_left = node_num_chunks(node->left);
+		if (index < num_left) {
+			node = node->left;
+		} else if (index == num_left) {
+			break;
+		} else {
+			index -= num_left + 1;
+			node = node->right;
+		}
+	}
+	return node;
+}
+
+void
+Table::ChunkTree::rebalance_from(
+	Node* node
+) noexcept {
+	Node* parent;
+	Node* subtree;
+	while (node) {
+		parent = node->parent;
+		bool const is_left = parent && parent->left == node;
+		subtree = node_rebalance(node);
+		if (!parent) {
+			m_root = subtree;
+		} else if (is_left) {
+			parent->left = subtree;
+		} else {
+			parent->right = subtree;
+		}
+		node = parent;
+	}
+}
+
+void
+Table::ChunkTree::destroy(
+	Node* const node
+) noexcept {
+	if (node) {
+		destroy(node->left);
+		destroy(node->right);
+		delete node;
+	}
+}
+
+unsigned
+Table::ChunkTree::find(
+	unsigned index,
+	unsigned& first_index
+) const noexcept {
+	DUCT_DEBUG_ASSERTE(index < num_records());
+	Node* node = m_root;
+	unsigned chunk_index = 0;
+	unsigned num_left;
+	first_index = 0;
+	for (;;) {
+		num_left = node_num_records(node->left);
+		if (index < num_left) {
+			node = node->left;
+			continue;
+		}
+		index -= num_left;
+		first_index += num_left;
+		chunk_index += node_num_chunks(node->left);
+		if (index < node->chunk.num_records) {
+			break;
+		}
+		index -= node->chunk.num_records;
+		first_index += node->chunk.num_records;
+		chunk_index += 1;
+		node = node->right;
+	}
+	return chunk_index;
+}
+
+unsigned
+Table::ChunkTree::first_index(
+	unsigned const index
+) const noexcept {
+	Node const* node = select(index);
+	unsigned first_index = node_num_records(node->left);
+	for (; node->parent; node = node->parent) {
+		if (node->parent->right == node) {
+			first_index
+				+= node_num_records(node->parent->left)
+				+ node->parent->chunk.num_records
+			;
+		}
+	}
+	return first_index;
+}
+
+void
+Table::ChunkTree::insert(
+	unsigned index,
+	Chunk const& chunk
+) {
+	DUCT_DEBUG_ASSERTE(index <= size());
+	Node* const node = new Node{chunk, nullptr, nullptr, nullptr, 1, 1, chunk.num_records};
+	++m_generation;
+	if (!m_root) {
+		m_root = node;
+		return;
+	}
+	Node* parent = m_root;
+	unsigned num_left;
+	for (;;) {
+		num_left = node_num_chunks(parent->left);
+		if (index <= num_left) {
+			if (!parent->left) {
+				parent->left = node;
+				break;
+			}
+			parent = parent->left;
+		} else {
+			index -= num_left + 1;
+			if (!parent->right) {
+				parent->right = node;
+				break;
+			}
+			parent = parent->right;
+		}
+	}
+	node->parent = parent;
+	rebalance_from(parent);
+}
+
+void
+Table::ChunkTree::erase(
+	unsigned const index
+) noexcept {
+	Node* node = select(index);
+	++m_generation;
+	if (node->left && node->right) {
+		// Take the successor's place
+		Node* const successor = first(node->right);
+		std::swap(node->chunk, successor->chunk);
+		node = successor;
+	}
+	Node* const child = node->left ? node->left : node->right;
+	Node* const parent = node->parent;
+	if (child) {
+		child->parent = parent;
+	}
+	if (!parent) {
+		m_root = child;
+	} else if (parent->left == node) {
+		parent->left = child;
+	} else {
+		parent->right = child;
+	}
+	delete node;
+	rebalance_from(parent);
+}
+
+void
+Table::ChunkTree::recount(
+	unsigned const index
+) noexcept {
+	for (Node* node = select(index); node; node = node->parent) {
+		node_update(node);
+	}
+}
+
+static void
+chunk_tree_recount(
+	ChunkNode* const node
+) noexcept {
+	if (node) {
+		chunk_tree_recount(node->left);
+		chunk_tree_recount(node->right);
+		node_update(node);
+	}
+}
+
+void
+Table::ChunkTree::recount() noexcept {
+	chunk_tree_recount(m_root);
+}
+
+// class Table::Iterator implementation
+
+Table::Iterator&
+Table::Iterator::operator++() noexcept {
+	++index;
+	if (index < table->m_num_records) {
+		auto const* chunk = &table->m_chunks.at(chunk_index, chunk_hint);
+		++inner_index;
+		if (inner_index < chunk->num_records) {
+			auto const& format = chunk_format(table->m_format, table->m_versions, *chunk);
+			data_offset += record_written_size(format, record_read(format, chunk->data + data_offset));
+			DUCT_DEBUG_ASSERTE(data_offset <= chunk->size);
+		} else {
+			++chunk_index;
+			inner_index = 0;
+			DUCT_ASSERTE(chunk_index < table->m_chunks.size());
+			chunk = &table->m_chunks.at(chunk_index, chunk_hint);
+			data_offset = chunk->offset_head();
+		}
+	}
+	return *this;
+}
+
+Table::Iterator&
+Table::Iterator::operator+=(
+	unsigned count
+) noexcept {
+	if (count == 0) {
+		return *this;
+	} else if (
+		count < Data::Table::CHUNK_MARK_STRIDE &&
+		index + count < table->m_num_records &&
+		inner_index + count < table->m_chunks.at(chunk_index, chunk_hint).num_records
+	) {
+		// Local to the chunk; cheaper to walk than to seek
+		auto const& chunk = table->m_chunks.at(chunk_index, chunk_hint);
+		data_offset = chunk_skip_records(
+			chunk_format(table->m_format, table->m_versions, chunk),
+			chunk, data_offset, count
+		);
+		index += count;
+		inner_index += count;
+	} else {
+		*this = table->iterator_at(index + min_ce(count, table->m_num_records));
+	}
+	return *this;
+}
+
+// class Table implementation
+
+#define HORD_SCOPE_CLASS Table
+
+void Table::free_chunks() {
+	for (auto& chunk : m_chunks) {
+		chunk_free(chunk);
+	}
+	m_chunks.clear();
+	m_num_records = 0;
+	m_versions.clear();
+	m_index.records.clear();
+	m_ordered_index.records.clear();
+	m_record_ids = {};
+}
+
+void Table::recount_chunks(
+	unsigned const from,
+	unsigned const count
+) noexcept {
+	unsigned const end = min_ce(from + count, m_chunks.size());
+	for (unsigned index = from; index < end; ++index) {
+		m_chunks.recount(index);
+	}
+	DUCT_DEBUG_ASSERTE(m_chunks.num_records() == m_num_records);
+}
+
+Table::~Table() noexcept {
+	free_chunks();
+}
+
+Table::Table(
+	Table&& other
+) noexcept {
+	(*this) = std::move(other);
+}
+
+Table&
+Table::operator=(
+	Table&& other
+) noexcept {
+	clear();
+	std::swap(m_num_records, other.m_num_records);
+	std::swap(m_schema, other.m_schema);
+	std::swap(m_format, other.m_format);
+	std::swap(m_chunks, other.m_chunks);
+	std::swap(m_allocator, other.m_allocator);
+	std::swap(m_version, other.m_version);
+	std::swap(m_versions, other.m_versions);
+	std::swap(m_index, other.m_index);
+	std::swap(m_ordered_index, other.m_ordered_index);
+	std::swap(m_record_ids, other.m_record_ids);
+	std::swap(m_dictionaries, other.m_dictionaries);
+	std::swap(m_bloom_columns, other.m_bloom_columns);
+	other.clear();
+	return *this;
+}
+
+Table::Table(
+	Data::TableSchema const& schema
+) noexcept {
+	replace_schema(schema);
+}
+
+// Rewrite a run of chunks into new chunks, freeing each source chunk
+// once consumed. Each value is read and morphed once; the record size
+// comes from the morphed values. Values of columns that change to
+// dictionary coding must already be in the new dictionaries.
+static void
+table_migrate_chunks(
+	Data::Table::RecordFormat const& old_format,
+	Data::TableSchema::column_vector_type const& old_columns,
+	Data::Table::dictionary_vector_type const& old_dictionaries,
+	Data::Table::RecordFormat const& new_format,
+	Data::TableSchema::column_vector_type const& new_columns,
+	Data::Table::dictionary_vector_type const& new_dictionaries,
+	Data::Table::Chunk* const* const chunks,
+	unsigned const num_chunks,
+	Data::ChunkAllocator* const allocator,
+	unsigned const version,
+	aux::vector<Data::Table::Chunk>& output
+) noexcept {
+	unsigned const num_new = new_columns.size();
+	aux::vector<unsigned> old_offsets(old_columns.size());
+	aux::vector<Data::ValueRef> values(num_new);
+	Data::Table::Chunk put{};
+	Record record;
+	unsigned offset;
+	unsigned size;
+	unsigned written_size;
+	for (unsigned chunk_index = 0; chunk_index < num_chunks; ++chunk_index) {
+		auto& take = *chunks[chunk_index];
+		offset = take.offset_head();
+		for (unsigned index = 0; index < take.num_records; ++index) {
+			record = record_read(old_format, take.data + offset);
+			offset += record_written_size(old_format, record);
+			record_field_offsets(
+				old_format, old_columns, record,
+				old_columns.size(), old_offsets.data()
+			);
+			size = record_sparse_size(new_format);
+			for (unsigned column_index = 0; column_index < num_new; ++column_index) {
+				auto const& column = new_columns[column_index];
+				auto& value = values[column_index];
+				if (column.index == ~0u) {
+					if (column.type.type() == Data::ValueType::dynamic) {
+						value = {};
+					} else {
+						value = {column.type};
+					}
+					size += new_format.init_sizes[column_index];
+				} else {
+					auto const old_type = old_columns[column.index].type;
+					unsigned const old_offset = old_offsets[column.index];
+					value = value_read(
+						old_type,
+						old_offset != ~0u ? record.data + old_offset : INIT_VALUE_DATA
+					);
+					if (old_type != column.type) {
+						if (type_coded(old_type)) {
+							value = dictionary_decode(old_dictionaries[column.index], value);
+						}
+						if (type_coded(column.type)) {
+							value.morph(type_decoded(column.type));
+							unsigned const code = dictionary_find(new_dictionaries[column_index], value);
+							value = value_coded(column.type, code != ~0u ? code : 0);
+						}
+					}
+					value.morph(column.type);
+					bool const is_dynamic = column.type.type() == Data::ValueType::dynamic;
+					if (
+						new_format.sparse_bits[column_index] == ~0u ||
+						!value_initial(value, is_dynamic)
+					) {
+						size += value_written_size(value, is_dynamic);
+					}
+				}
+			}
+			written_size = record_written_size(new_format, size);
+			if (put.space_tail() < written_size) {
+				if (put.data) {
+					output.push_back(std::move(put));
+				}
+				put = {};
+				put.allocator = allocator;
+				put.version = version;
+				chunk_allocate(put, max_ce(written_size, CHUNK_SIZE));
+			}
+			put.tail += record_write_values(
+				new_format, new_columns,
+				size, num_new, values.data(),
+				put.tail
+			);
+			++put.num_records;
+			// NB: Inserted columns have their initial size
+			put.dirty = !new_format.stride;
+		}
+		chunk_free(take);
+	}
+	if (put.data) {
+		output.push_back(std::move(put));
+	}
+}
+
+void
+Table::migrate(
+	RecordFormat const& format,
+	Data::TableSchema::column_vector_type const& columns,
+	dictionary_vector_type const& dictionaries
+) {
+	upgrade_chunks();
+	auto const& old_columns = m_schema.columns();
+	// NB: Records are rewritten row-major
+	if (m_format.columnar) {
+		for (auto& chunk : m_chunks) {
+			chunk_transpose(m_format, old_columns, chunk, false);
+		}
+		m_format.columnar = false;
+	}
+
+	// Partition chunks between workers
+	aux::vector<Data::Table::Chunk*> chunks{};
+	chunks.reserve(m_chunks.size());
+	for (auto& chunk : m_chunks) {
+		chunks.push_back(&chunk);
+	}
+	unsigned const num_chunks = chunks.size();
+	unsigned const num_workers = max_ce(1u, min_ce(
+		std::thread::hardware_concurrency(),
+		num_chunks / MIGRATE_CHUNKS_PER_WORKER
+	));
+	aux::vector<aux::vector<Data::Table::Chunk>> outputs(num_workers);
+	auto const migrate_partition = [&](unsigned const worker) {
+		unsigned const first = num_chunks * worker / num_workers;
+		unsigned const last = num_chunks * (worker + 1) / num_workers;
+		table_migrate_chunks(
+			m_format, old_columns, m_dictionaries, format, columns, dictionaries,
+			chunks.data() + first, last - first,
+			m_allocator, m_version, outputs[worker]
+		);
+	};
+	aux::vector<std::thread> threads{};
+	threads.reserve(num_workers - 1);
+	for (unsigned worker = 1; worker < num_workers; ++worker) {
+		try {
+			threads.emplace_back(migrate_partition, worker);
+		} catch (std::system_error const&) {
+			break;
+		}
+	}
+	// NB: Partitions without a thread are migrated here
+	for (unsigned worker = threads.size() + 1; worker < num_workers; ++worker) {
+		migrate_partition(worker);
+	}
+	migrate_partition(0);
+	for (auto& thread : threads) {
+		thread.join();
+	}
+
+	// Stitch partitions in order
+	m_chunks.clear();
+	for (auto& output : outputs) {
+		for (auto& chunk : output) {
+			m_chunks.push_back(chunk);
+		}
+	}
+	m_format = format;
+	if (m_format.columnar) {
+		for (auto& chunk : m_chunks) {
+			chunk_transpose(m_format, columns, chunk, true);
+		}
+	}
+}
+
+unsigned
+Table::upgrade_chunk(
+	unsigned const index
+) noexcept {
+	auto& chunk = m_chunks[index];
+	auto const* const version = chunk_version(m_versions, chunk);
+	if (!version) {
+		return 1;
+	} else if (chunk.num_records == 0) {
+		chunk.version = m_version;
+		return 1;
+	}
+	auto const& old_columns = version->schema.columns();
+	if (version->format.columnar) {
+		chunk_transpose(version->format, old_columns, chunk, false);
+	}
+	auto* const take = &chunk;
+	aux::vector<Data::Table::Chunk> output{};
+	table_migrate_chunks(
+		version->format, old_columns, m_dictionaries,
+		m_format, version->columns, m_dictionaries,
+		&take, 1, m_allocator, m_version, output
+	);
+	if (m_format.columnar) {
+		for (auto& put : output) {
+			chunk_transpose(m_format, m_schema.columns(), put, true);
+		}
+	}
+	unsigned const count = output.size();
+	chunk = std::move(output[0]);
+	for (unsigned put_index = 1; put_index < count; ++put_index) {
+		m_chunks.insert(index + put_index, output[put_index]);
+	}
+	recount_chunks(index, count);
+	return count;
+}
+
+void
+Table::upgrade_chunk(
+	Data::Table::Iterator& it
+) noexcept {
+	// NB: The iterator may move to an adjacent chunk
+	while (
+		it.chunk_index < m_chunks.size() &&
+		chunk_version(m_versions, m_chunks[it.chunk_index])
+	) {
+		upgrade_chunk(it.chunk_index);
+		it = iterator_at(it.index);
+	}
+}
+
+void
+Table::upgrade_chunks() noexcept {
+	if (m_versions.empty()) {
+		return;
+	}
+	for (unsigned index = 0; index < m_chunks.size();) {
+		index += upgrade_chunk(index);
+	}
+	m_versions.clear();
+}
+
+// Whether columns are only dropped or appended, so records can be
+// decoded through a version rather than rewritten
+static bool
+columns_drop_or_append(
+	Data::TableSchema::column_vector_type const& old_columns,
+	Data::TableSchema::column_vector_type const& new_columns
+) noexcept {
+	unsigned next_index = 0;
+	bool appended = false;
+	for (auto const& column : new_columns) {
+		if (column.index == ~0u) {
+			appended = true;
+		} else if (
+			appended ||
+			column.index < next_index ||
+			column.type != old_columns[column.index].type
+		) {
+			return false;
+		} else {
+			next_index = column.index + 1;
+		}
+	}
+	return true;
+}
+
+#define HORD_SCOPE_FUNC configure
+bool
+Table::configure(
+	Data::TableSchema const& schema
 ) {
 	auto const& old_columns = m_schema.columns();
 	auto const& new_columns = schema.columns();
@@ -635,442 +2906,3076 @@ Table::configure(
 		return replace_schema(schema);
 	}
 
-	bool rewrite_records = num_new != num_old;
-	bool column_renamed = false;
-	bool has_reference = false;
-	auto const end_new = new_columns.cend();
-	{// Validate new schema and compare
-	unsigned index = 0;
-	for (auto it = new_columns.cbegin(); it < end_new; ++it, ++index) {
-		if (it->index != ~0u && it->index >= num_old) {
-			HORD_THROW_FUNC(
-				ErrorCode::table_column_index_invalid,
-				"column index is out-of-bounds"
-			);
-		} else if (it->name.empty()) {
-			HORD_THROW_FUNC(
-				ErrorCode::table_column_name_empty,
-				"column name is empty"
+	bool rewrite_records = num_new != num_old;
+	bool column_renamed = false;
+	bool has_reference = false;
+	auto const end_new = new_columns.cend();
+	{// Validate new schema and compare
+	unsigned index = 0;
+	for (auto it = new_columns.cbegin(); it < end_new; ++it, ++index) {
+		if (it->index != ~0u && it->index >= num_old) {
+			HORD_THROW_FUNC(
+				ErrorCode::table_column_index_invalid,
+				"column index is out-of-bounds"
+			);
+		} else if (it->name.empty()) {
+			HORD_THROW_FUNC(
+				ErrorCode::table_column_name_empty,
+				"column name is empty"
+			);
+		} else {
+			for (auto search = it + 1; search < end_new; ++search) {
+				if (search->name == it->name) {
+					HORD_THROW_FUNC(
+						ErrorCode::table_column_name_shared,
+						"column name is shared with another column"
+					);
+				}
+			}
+		}
+		// NB: Renamed columns are irrelevant if rewriting records
+		has_reference |= it->index != ~0u;
+		if (!rewrite_records) {
+			rewrite_records = it->index == ~0u || it->index != index;
+			if (!rewrite_records) {
+				auto const& old_column = old_columns[it->index];
+				rewrite_records = it->type != old_column.type;
+				if (!rewrite_records && !column_renamed) {
+					column_renamed = it->name != old_column.name;
+				}
+			}
+		}
+	}}
+
+	// NB: Must validate new before doing this
+	// Implicitly includes condition of num_old == 0
+	if (!has_reference) {
+		return replace_schema(schema);
+	} else if (!rewrite_records) {
+		if (column_renamed) {
+			// Only column names changed
+			return m_schema.assign(schema);
+		} else {
+			// No change
+			return false;
+		}
+	}
+
+	bool versioned = false;
+	{// Rewrite records with new field layout
+	dictionary_vector_type dictionaries{};
+	dictionaries_build(dictionaries, new_columns);
+	for (unsigned index = 0; index < dictionaries.size(); ++index) {
+		auto const& column = new_columns[index];
+		if (!type_coded(column.type) || column.index == ~0u) {
+			continue;
+		} else if (column.type == old_columns[column.index].type) {
+			dictionaries[index] = m_dictionaries[column.index];
+			continue;
+		}
+		// NB: Values are added up front so that migration can fail
+		// before modifying the table and workers only read
+		auto const type = type_decoded(column.type);
+		for (auto it = begin(); it.can_advance(); ++it) {
+			auto value = get_field(it, column.index);
+			value.morph(type);
+			if (dictionary_add(dictionaries[index], column.type, value) == ~0u) {
+				HORD_THROW_FUNC(
+					ErrorCode::table_dictionary_full,
+					"column has more distinct values than its dictionary can code"
+				);
+			}
+		}
+	}
+	RecordFormat format{};
+	record_format_build(format, m_format.layout, m_format.compact, new_columns);
+	versioned = !empty() && columns_drop_or_append(old_columns, new_columns);
+	if (versioned) {
+		// Existing chunks keep their format; map older versions
+		// through the new columns
+		Data::TableSchema::column_vector_type columns{};
+		for (auto& version : m_versions) {
+			columns = new_columns;
+			for (auto& column : columns) {
+				if (column.index != ~0u) {
+					column.index = version.columns[column.index].index;
+				}
+			}
+			version.columns.swap(columns);
+		}
+		m_versions.push_back({m_version, m_schema, m_format, new_columns});
+		++m_version;
+		m_format = std::move(format);
+	} else {
+		migrate(format, new_columns, dictionaries);
+	}
+	m_dictionaries = std::move(dictionaries);
+	}
+	unsigned index_column = ~0u;
+	unsigned ordered_index_column = ~0u;
+	aux::vector<unsigned> bloom_columns{};
+	for (unsigned index = 0; index < num_new; ++index) {
+		unsigned const old_index = new_columns[index].index;
+		if (old_index == ~0u) {
+			continue;
+		}
+		if (old_index == m_index.column && index_column == ~0u) {
+			index_column = index;
+		}
+		if (old_index == m_ordered_index.column && ordered_index_column == ~0u) {
+			ordered_index_column = index;
+		}
+		if (bloom_column(old_index) && bloom_valid(new_columns[index].type)) {
+			bloom_columns.push_back(index);
+		}
+	}
+	bool const changed = m_schema.assign(schema);
+	m_index.column = index_column;
+	m_ordered_index.column = ordered_index_column;
+	if (versioned) {
+		// NB: Kept columns keep their types and records keep their
+		// IDs, so only indexes of dropped columns are cleared
+		if (index_column == ~0u) {
+			m_index.records.clear();
+		}
+		if (ordered_index_column == ~0u) {
+			m_ordered_index.records.clear();
+		}
+		if (index_column == ~0u && ordered_index_column == ~0u) {
+			m_record_ids = {};
+		}
+	} else {
+		index_rebuild();
+	}
+	m_bloom_columns = std::move(bloom_columns);
+	return changed;
+}
+#undef HORD_SCOPE_FUNC
+
+#define HORD_SCOPE_FUNC replace_schema
+bool
+Table::replace_schema(
+	Data::TableSchema const& schema
+) {
+	bool changed = m_schema.assign(schema);
+	if (changed) {
+		clear();
+		m_index.column = ~0u;
+		m_ordered_index.column = ~0u;
+		m_bloom_columns.clear();
+	}
+	record_format_build(m_format, m_format.layout, m_format.compact, m_schema.columns());
+	return changed;
+}
+#undef HORD_SCOPE_FUNC
+
+#define HORD_SCOPE_FUNC set_layout
+bool
+Table::set_layout(
+	Data::Table::Layout const layout
+) {
+	if (layout == m_format.layout) {
+		return false;
+	}
+	auto columns = m_schema.columns();
+	unsigned index = 0;
+	for (auto& column : columns) {
+		column.index = index++;
+	}
+	RecordFormat format{};
+	record_format_build(format, layout, m_format.compact, columns);
+	migrate(format, columns, m_dictionaries);
+	return true;
+}
+#undef HORD_SCOPE_FUNC
+
+#define HORD_SCOPE_FUNC set_compact_headers
+bool
+Table::set_compact_headers(
+	bool const compact
+) {
+	if (compact == m_format.compact) {
+		return false;
+	} else if (m_format.stride) {
+		// NB: Headerless records are unchanged
+		m_format.compact = compact;
+		return true;
+	}
+	auto columns = m_schema.columns();
+	unsigned index = 0;
+	for (auto& column : columns) {
+		column.index = index++;
+	}
+	RecordFormat format{};
+	record_format_build(format, m_format.layout, compact, columns);
+	migrate(format, columns, m_dictionaries);
+	return true;
+}
+#undef HORD_SCOPE_FUNC
+
+Table::Iterator
+Table::iterator_at(
+	unsigned const index
+) {
+	if (index >= m_num_records) {
+		return end();
+	}
+	unsigned first_index;
+	unsigned const chunk_index = m_chunks.find(index, first_index);
+	ChunkTree::Hint hint{};
+	auto& chunk = m_chunks.at(chunk_index, hint);
+	unsigned const inner_index = index - first_index;
+	DUCT_DEBUG_ASSERTE(inner_index < chunk.num_records);
+	return {
+		this,
+		index,
+		chunk_index,
+		inner_index,
+		chunk_record_offset(chunk_format(m_format, m_versions, chunk), chunk, inner_index),
+		hint
+	};
+}
+
+Table::Cursor
+Table::cursor(
+	aux::vector<bool> mask
+) {
+	Data::Table::Cursor cursor{};
+	cursor.it = begin();
+	cursor.mask = std::move(mask);
+	get_fields(cursor);
+	return cursor;
+}
+
+void
+Table::clear() noexcept {
+	// NB: Empty chunks are only valid in an empty table
+	if (!m_chunks.empty()) {
+		auto it = m_chunks.begin();
+		for (++it; it != m_chunks.end(); ++it) {
+			chunk_free(*it);
+		}
+		m_chunks.truncate(1);
+		chunk_clear(m_chunks.front());
+		m_chunks.front().version = m_version;
+		m_chunks.recount(0);
+	}
+	m_num_records = 0;
+	m_versions.clear();
+	m_index.records.clear();
+	m_ordered_index.records.clear();
+	m_record_ids = {};
+	dictionaries_build(m_dictionaries, m_schema.columns());
+}
+
+static void
+table_write_records(
+	Data::Table::Chunk& chunk,
+	aux::vector<Record>& records,
+	unsigned const size,
+	Data::Table::RecordFormat const& format
+) {
+	// NB: Shared data is only read
+	if (chunk.size < size || chunk_shared(chunk)) {
+		chunk_allocate(chunk, size);
+	}
+	unsigned offset = 0;
+	for (auto const& record : records) {
+		offset += record_write(format, record, chunk.data + offset);
+	}
+	chunk_set_bounds(chunk, records.size(), 0, offset);
+	chunk.dirty = false;
+	// NB: Records come from other chunks
+	chunk.zones.clear();
+	chunk.blooms.clear();
+	records.clear();
+}
+
+static void
+table_pack_columns(
+	Data::Table::RecordFormat const& format,
+	Data::TableSchema::column_vector_type const& columns,
+	Data::Table::chunk_tree_type& chunks
+) {
+	Data::Table::chunk_tree_type packed{};
+	Data::Table::Chunk put{};
+	unsigned taken;
+	unsigned count;
+	for (auto& take : chunks) {
+		for (taken = 0; taken < take.num_records; taken += count) {
+			if (put.num_records == chunk_capacity(format, put)) {
+				if (put.data) {
+					packed.push_back(put);
+					put = {};
+				}
+				put.allocator = take.allocator;
+				put.version = take.version;
+				chunk_columns_allocate(format, put, 0);
+			}
+			count = min_ce(
+				take.num_records - taken,
+				chunk_capacity(format, put) - put.num_records
+			);
+			chunk_columns_copy(format, columns, take, taken, put, put.num_records, count);
+			chunk_columns_set_count(format, put, put.num_records + count);
+		}
+		chunk_free(take);
+	}
+	if (put.data) {
+		packed.push_back(put);
+	}
+	chunks.swap(packed);
+}
+
+void
+Table::optimize_storage() {
+	if (empty()) {
+		return;
+	}
+	upgrade_chunks();
+	if (m_format.columnar) {
+		table_pack_columns(m_format, m_schema.columns(), m_chunks);
+		return;
+	}
+
+	m_chunks.insert(0, make_chunk());
+	auto it_put = m_chunks.begin();
+	auto it_take = it_put;
+	++it_take;
+	unsigned num_put = 0;
+	unsigned offset;
+	unsigned take_count = 0;
+	unsigned accum_data_size = 0;
+	unsigned put_capacity = CHUNK_SIZE;
+	Record orig_record;
+	aux::vector<Record> records{};
+	records.reserve(256);
+	for (; it_take != m_chunks.end(); ++it_take) {
+		offset = it_take->offset_head();
+		for (unsigned index = 0; index < it_take->num_records; ++index) {
+			orig_record = record_read(m_format, it_take->data + offset);
+			offset += record_written_size(m_format, orig_record);
+			records.push_back({});
+			auto& record = records.back();
+			record.data = orig_record.data;
+			record.size = record_data_size(m_format, m_schema, orig_record);
+			accum_data_size += record_written_size(m_format, record);
+			if (0 < take_count && put_capacity <= accum_data_size) {
+				table_write_records(*it_put, records, max_ce(put_capacity, accum_data_size), m_format);
+				++it_put;
+				++num_put;
+				take_count = 0;
+				accum_data_size = 0;
+				put_capacity = max_ce(it_put->size, CHUNK_SIZE);
+			}
+		}
+		++take_count;
+	}
+	if (!records.empty()) {
+		table_write_records(*it_put, records, max_ce(put_capacity, accum_data_size), m_format);
+		++it_put;
+		++num_put;
+	}
+	for (it_take = it_put; it_take != m_chunks.end(); ++it_take) {
+		chunk_free(*it_take);
+	}
+	m_chunks.truncate(num_put);
+	m_chunks.recount();
+}
+
+void
+Table::compact_storage() noexcept {
+	upgrade_chunks();
+	for (auto& chunk : m_chunks) {
+		if (m_format.stride || !chunk.dirty) {
+			// Unchanged
+		} else if (
+			chunk_slack(m_format, m_schema, chunk) * CHUNK_COMPACT_DIVISOR
+			> chunk.space_used()
+		) {
+			chunk_unshare(m_format, m_schema.columns(), chunk);
+			chunk_compact(m_format, m_schema, chunk);
+			// NB: Zones and filters are rebuilt to drop replaced values
+			chunk.zones.clear();
+			chunk.blooms.clear();
+		} else {
+			// NB: Slack is reevaluated when modified again
+			chunk.dirty = false;
+		}
+		if (chunk.zones.empty() && 0 < chunk.num_records) {
+			chunk_zones_build(m_format, m_schema, chunk);
+		}
+		if (!m_bloom_columns.empty() && 0 < chunk.num_records) {
+			chunk_blooms_build(m_format, m_schema, m_bloom_columns, chunk);
+		}
+	}
+}
+
+bool
+Table::assign(
+	Data::Table const& table
+) {
+	if (&table == this) {
+		return false;
+	}
+	free_chunks();
+	bool schema_changed = replace_schema(table.schema());
+	m_format = table.m_format;
+	m_version = table.m_version;
+	m_versions = table.m_versions;
+	m_index = table.m_index;
+	m_ordered_index = table.m_ordered_index;
+	m_record_ids = table.m_record_ids;
+	m_dictionaries = table.m_dictionaries;
+	m_bloom_columns = table.m_bloom_columns;
+	for (auto const& chunk : table.m_chunks) {
+		if (chunk.num_records == 0) {
+			continue;
+		}
+		m_chunks.push_back(chunk_share(chunk));
+	}
+	m_num_records = table.m_num_records;
+	return schema_changed;
+}
+
+#define HORD_SCOPE_FUNC encode_value
+Data::ValueRef
+Table::encode_value(
+	unsigned const column_index,
+	Data::ValueRef value
+) {
+	auto const type = column(column_index).type;
+	if (!type_coded(type)) {
+		return value;
+	}
+	value.morph(type_decoded(type));
+	unsigned const code = dictionary_add(m_dictionaries[column_index], type, value);
+	if (code == ~0u) {
+		HORD_THROW_FUNC(
+			ErrorCode::table_dictionary_full,
+			"column dictionary has no code left for a new value"
+		);
+	}
+	return value_coded(type, code);
+}
+#undef HORD_SCOPE_FUNC
+
+// NB: Fields are encoded into a copy so that callers can reuse them
+Data::ValueRef*
+Table::encode_fields(
+	unsigned const num_records,
+	unsigned const num_fields,
+	unsigned const fields_stride,
+	Data::ValueRef* const fields,
+	aux::vector<Data::ValueRef>& encoded
+) {
+	if (m_dictionaries.empty()) {
+		return fields;
+	}
+	encoded.assign(fields, fields + num_records * fields_stride);
+	for (unsigned index = 0; index < num_records * fields_stride; ++index) {
+		unsigned const column_index = index % fields_stride;
+		if (column_index < num_fields) {
+			encoded[index] = encode_value(column_index, encoded[index]);
+		}
+	}
+	return encoded.data();
+}
+
+void
+Table::insert(
+	Data::Table::Iterator& it,
+	unsigned num_fields,
+	Data::ValueRef* fields
+) {
+	DUCT_ASSERTE(it.table == this);
+
+	Record record;
+	bool split_made = false;
+	aux::vector<Data::ValueRef> encoded{};
+	{ // Calculate record size
+	num_fields = min_ce(num_columns(), num_fields);
+	fields = encode_fields(1, num_fields, num_fields, fields, encoded);
+	unsigned const record_size = record_init_size(
+		m_format, m_schema.columns(), num_fields, fields
+	);
+	upgrade_chunk(it);
+	if (m_format.columnar) {
+		insert_columns(it, num_fields, fields);
+		index_add(it.index);
+		return;
+	} else if (m_chunks.empty()) {
+		Data::Table::Chunk chunk = make_chunk();
+		chunk_allocate(chunk, max_ce(record_written_size(m_format, record_size), CHUNK_SIZE));
+		m_chunks.push_back(chunk);
+		it = begin();
+	}
+	// Make record
+	chunk_unshare(m_format, m_schema.columns(), m_chunks[it.chunk_index]);
+	Data::Table::Chunk split{};
+	if (record_make(m_format, record, m_chunks[it.chunk_index], split, it, record_size)) {
+		m_chunks.insert(it.chunk_index, split);
+		split_made = true;
+	}}
+
+	// Write supplied field values and empty values for the rest
+	record_write_values(
+		m_format, m_schema.columns(),
+		record.size, num_fields, fields,
+		record.data - record_meta_size(m_format, record.size)
+	);
+	auto& chunk = m_chunks[it.chunk_index];
+	chunk_zones_add(m_schema.columns(), chunk, chunk.num_records, num_fields, fields);
+	chunk_blooms_add(m_schema.columns(), chunk, chunk.num_records, num_fields, fields);
+	++chunk.num_records;
+	chunk.dirty |= !m_format.stride;
+	++m_num_records;
+	// NB: The split chunk is on either side of the source chunk
+	if (split_made) {
+		recount_chunks(max_ce(it.chunk_index, 1u) - 1, 3);
+	} else {
+		recount_chunks(it.chunk_index, 1);
+	}
+	index_add(it.index);
+}
+
+void
+Table::insert_columns(
+	Data::Table::Iterator& it,
+	unsigned const num_fields,
+	Data::ValueRef const* const fields
+) noexcept {
+	auto const& columns = m_schema.columns();
+	if (m_chunks.empty()) {
+		Data::Table::Chunk chunk = make_chunk();
+		chunk_columns_allocate(m_format, chunk, 1);
+		m_chunks.push_back(chunk);
+		it = begin();
+	}
+	unsigned const chunk_index = it.chunk_index;
+	auto* chunk = &m_chunks[chunk_index];
+	if (chunk->num_records == chunk_capacity(m_format, *chunk)) {
+		// Appending to the chunk starts a new one; otherwise the upper
+		// half moves to a new chunk
+		unsigned const move_from
+			= it.inner_index == chunk->num_records
+			? chunk->num_records
+			: chunk->num_records / 2
+		;
+		Data::Table::Chunk split = make_chunk();
+		chunk_columns_allocate(m_format, split, 0);
+		chunk_columns_copy(
+			m_format, columns,
+			*chunk, move_from, split, 0,
+			chunk->num_records - move_from
+		);
+		chunk_columns_set_count(m_format, split, chunk->num_records - move_from);
+		chunk_columns_set_count(m_format, *chunk, move_from);
+		chunk->marks.clear();
+		m_chunks.insert(chunk_index + 1, split);
+		if (it.inner_index >= move_from) {
+			++it.chunk_index;
+			it.inner_index -= move_from;
+			it.data_offset = it.inner_index * m_format.stride;
+		}
+		chunk = &m_chunks[it.chunk_index];
+	}
+	chunk_unshare(m_format, columns, *chunk);
+	chunk_columns_shift(m_format, columns, *chunk, it.inner_index, true);
+	chunk_columns_write(m_format, columns, *chunk, it.inner_index, num_fields, fields);
+	chunk_zones_add(columns, *chunk, chunk->num_records, num_fields, fields);
+	chunk_blooms_add(columns, *chunk, chunk->num_records, num_fields, fields);
+	chunk_columns_set_count(m_format, *chunk, chunk->num_records + 1);
+	++m_num_records;
+	recount_chunks(chunk_index, 2);
+}
+
+void
+Table::append_columns(
+	unsigned const num_records,
+	unsigned const num_fields,
+	unsigned const fields_stride,
+	Data::ValueRef const* fields
+) noexcept {
+	auto const& columns = m_schema.columns();
+	unsigned const first_chunk = m_chunks.empty() ? 0 : m_chunks.size() - 1;
+	if (!m_chunks.empty()) {
+		upgrade_chunk(first_chunk);
+	}
+	Data::Table::Chunk* chunk = m_chunks.empty() ? nullptr : &m_chunks.back();
+	if (chunk) {
+		chunk_unshare(m_format, columns, *chunk);
+	}
+	unsigned count;
+	for (unsigned index = 0; index < num_records; index += count) {
+		if (!chunk || chunk->num_records == chunk_capacity(m_format, *chunk)) {
+			m_chunks.push_back(make_chunk());
+			chunk = &m_chunks.back();
+			chunk_columns_allocate(m_format, *chunk, 0);
+		}
+		count = min_ce(
+			num_records - index,
+			chunk_capacity(m_format, *chunk) - chunk->num_records
+		);
+		for (unsigned inner = 0; inner < count; ++inner) {
+			chunk_columns_write(
+				m_format, columns, *chunk, chunk->num_records + inner,
+				num_fields, fields
+			);
+			chunk_zones_add(columns, *chunk, chunk->num_records + inner, num_fields, fields);
+			chunk_blooms_add(columns, *chunk, chunk->num_records + inner, num_fields, fields);
+			fields += fields_stride;
+		}
+		chunk_columns_set_count(m_format, *chunk, chunk->num_records + count);
+	}
+	m_num_records += num_records;
+	recount_chunks(first_chunk, m_chunks.size() - first_chunk);
+	index_append(m_num_records - num_records, num_records);
+}
+
+void
+Table::append_batch(
+	unsigned const num_records,
+	unsigned num_fields,
+	Data::ValueRef* fields
+) {
+	if (num_records == 0) {
+		return;
+	}
+	auto const& columns = m_schema.columns();
+	unsigned const fields_stride = num_fields;
+	num_fields = min_ce(num_columns(), num_fields);
+	aux::vector<Data::ValueRef> encoded{};
+	fields = encode_fields(num_records, num_fields, fields_stride, fields, encoded);
+	if (m_format.columnar) {
+		append_columns(num_records, num_fields, fields_stride, fields);
+		return;
+	}
+	aux::vector<unsigned> sizes(num_records);
+	unsigned remaining_size = 0;
+	for (unsigned index = 0; index < num_records; ++index) {
+		sizes[index] = record_init_size(
+			m_format, columns, num_fields, fields + index * fields_stride
+		);
+		remaining_size += record_written_size(m_format, sizes[index]);
+	}
+
+	if (m_chunks.empty()) {
+		m_chunks.push_back(make_chunk());
+	}
+	upgrade_chunk(m_chunks.size() - 1);
+	unsigned const first_chunk = m_chunks.size() - 1;
+	auto* chunk = &m_chunks.back();
+	chunk_unshare(m_format, columns, *chunk);
+	chunk->marks.clear();
+	unsigned written_size;
+	for (unsigned index = 0; index < num_records; ++index) {
+		written_size = record_written_size(m_format, sizes[index]);
+		if (chunk->space_tail() < written_size) {
+			// NB: Only an empty table can have an empty chunk
+			if (0 < chunk->num_records) {
+				m_chunks.push_back(make_chunk());
+				chunk = &m_chunks.back();
+			}
+			// NB: The last chunk of the batch fits the rest of it
+			chunk_allocate(*chunk, max_ce(written_size, min_ce(remaining_size, CHUNK_SIZE)));
+		}
+		record_write_values(
+			m_format, columns,
+			sizes[index], num_fields, fields + index * fields_stride,
+			chunk->tail
+		);
+		chunk_zones_add(
+			columns, *chunk, chunk->num_records,
+			num_fields, fields + index * fields_stride
+		);
+		chunk_blooms_add(
+			columns, *chunk, chunk->num_records,
+			num_fields, fields + index * fields_stride
+		);
+		chunk->tail += written_size;
+		++chunk->num_records;
+		chunk->dirty |= !m_format.stride;
+		remaining_size -= written_size;
+	}
+	m_num_records += num_records;
+	recount_chunks(first_chunk, m_chunks.size() - first_chunk);
+	index_append(m_num_records - num_records, num_records);
+}
+
+// Move unselected records down over selected records
+static void
+chunk_remove_records(
+	Data::Table::RecordFormat const& format,
+	Data::Table::Chunk& chunk,
+	Data::Table::Selection const& selection,
+	unsigned const first_index
+) noexcept {
+	unsigned read_offset = chunk.offset_head();
+	unsigned write_offset = read_offset;
+	unsigned num_kept = 0;
+	unsigned size;
+	for (unsigned index = 0; index < chunk.num_records; ++index) {
+		size = record_written_size(format, record_read(format, chunk.data + read_offset));
+		if (!selection.test(first_index + index)) {
+			// NB: Slots are relative to the record data, which moves
+			// with its header
+			if (write_offset != read_offset) {
+				std::memmove(chunk.data + write_offset, chunk.data + read_offset, size);
+			}
+			write_offset += size;
+			++num_kept;
+		}
+		read_offset += size;
+	}
+	chunk.num_records = num_kept;
+	chunk.tail = chunk.data + write_offset;
+	chunk.marks.clear();
+}
+
+static void
+chunk_columns_remove(
+	Data::Table::RecordFormat const& format,
+	Data::TableSchema::column_vector_type const& columns,
+	Data::Table::Chunk& chunk,
+	Data::Table::Selection const& selection,
+	unsigned const first_index
+) noexcept {
+	unsigned num_kept = 0;
+	for (unsigned column = 0; column < columns.size(); ++column) {
+		unsigned const size = column_fixed_size(columns[column].type);
+		auto* const data = column_data(format, chunk, column);
+		num_kept = 0;
+		for (unsigned index = 0; index < chunk.num_records; ++index) {
+			if (selection.test(first_index + index)) {
+				continue;
+			} else if (num_kept != index) {
+				std::memcpy(data + num_kept * size, data + index * size, size);
+			}
+			++num_kept;
+		}
+	}
+	chunk_columns_set_count(format, chunk, num_kept);
+}
+
+void
+Table::remove(
+	Data::Table::Iterator& it
+) noexcept {
+	DUCT_ASSERTE(it.table == this);
+	if (!it.can_advance()) {
+		return;
+	}
+	index_remove(it.index);
+	upgrade_chunk(it);
+	auto& chunk = m_chunks[it.chunk_index];
+	chunk_unshare(m_format, m_schema.columns(), chunk);
+	if (m_format.columnar) {
+		chunk_columns_shift(m_format, m_schema.columns(), chunk, it.inner_index, false);
+		chunk_columns_set_count(m_format, chunk, chunk.num_records - 1);
+	} else {
+		unsigned const size = record_written_size(
+			m_format,
+			record_read(m_format, chunk.data + it.data_offset)
+		);
+		Data::Table::Chunk split_unused{};
+		DUCT_ASSERTE(!segment_resize(chunk, split_unused, it, size, 0));
+		--chunk.num_records;
+	}
+	--m_num_records;
+	if (chunk.num_records == 0 && 1 < m_chunks.size()) {
+		chunk_free(chunk);
+		m_chunks.erase(it.chunk_index);
+		if (it.chunk_index < m_chunks.size()) {
+			it.inner_index = 0;
+			it.data_offset = m_chunks[it.chunk_index].offset_head();
+		} else {
+			it = end();
+		}
+	} else {
+		recount_chunks(it.chunk_index, 1);
+		if (
+			it.inner_index == chunk.num_records &&
+			it.chunk_index + 1 < m_chunks.size()
+		) {
+			++it.chunk_index;
+			it.inner_index = 0;
+			it.data_offset = m_chunks[it.chunk_index].offset_head();
+		}
+	}
+}
+
+unsigned
+Table::remove(
+	Data::Table::Selection const& selection
+) noexcept {
+	DUCT_ASSERTE(selection.num_records == m_num_records);
+	unsigned const num_removed = selection.count();
+	if (num_removed == 0) {
+		return 0;
+	}
+	index_remove(selection);
+	upgrade_chunks();
+
+	Data::Table::chunk_tree_type kept{};
+	unsigned first_index = 0;
+	unsigned num_chunk_removed;
+	for (auto& chunk : m_chunks) {
+		num_chunk_removed = 0;
+		unsigned const end_index = first_index + chunk.num_records;
+		for (unsigned index = first_index; index < end_index; ++index) {
+			num_chunk_removed += selection.test(index);
+		}
+		if (num_chunk_removed == chunk.num_records) {
+			chunk_free(chunk);
+			first_index += num_chunk_removed;
+			continue;
+		} else if (0 < num_chunk_removed) {
+			chunk_unshare(m_format, m_schema.columns(), chunk);
+			unsigned const num_records = chunk.num_records;
+			if (m_format.columnar) {
+				chunk_columns_remove(m_format, m_schema.columns(), chunk, selection, first_index);
+			} else {
+				chunk_remove_records(m_format, chunk, selection, first_index);
+			}
+			first_index += num_records;
+		} else {
+			first_index += chunk.num_records;
+		}
+		kept.push_back(chunk);
+	}
+	m_chunks.swap(kept);
+	m_num_records -= num_removed;
+	return num_removed;
+}
+
+unsigned
+Table::erase(
+	Data::Table::Iterator const& first,
+	Data::Table::Iterator const& last
+) noexcept {
+	DUCT_ASSERTE(first.table == this && last.table == this);
+	unsigned const end_index = min_ce(last.index, m_num_records);
+	if (first.index >= end_index) {
+		return 0;
+	}
+	Data::Table::Selection selection{};
+	selection.reset(m_num_records, false);
+	for (unsigned index = first.index; index < end_index; ++index) {
+		selection.bits[index >> 6] |= std::uint64_t{1} << (index & 63);
+	}
+	return remove(selection);
+}
+
+void
+Table::set_field(
+	Data::Table::Iterator& it,
+	unsigned column_index,
+	Data::ValueRef new_value
+) {
+	DUCT_ASSERTE(it.table == this);
+	if (column_index >= num_columns() || !it.can_advance()) {
+		return;
+	}
+	auto const type = column(column_index).type;
+	if (type.type() == Data::ValueType::null) {
+		return;
+	}
+	bool const is_dynamic = type.type() == Data::ValueType::dynamic;
+	new_value.morph(type_decoded(type));
+	auto const stored_value = encode_value(column_index, new_value);
+	index_update(m_index, *this, m_record_ids, it, column_index, new_value);
+	index_update(m_ordered_index, *this, m_record_ids, it, column_index, new_value);
+	new_value = stored_value;
+	upgrade_chunk(it);
+	chunk_unshare(m_format, m_schema.columns(), m_chunks[it.chunk_index]);
+	auto& zones = m_chunks[it.chunk_index].zones;
+	if (!zones.empty() && zone_column(type)) {
+		zone_add(zones[column_index], zone_key(new_value));
+	}
+	auto& blooms = m_chunks[it.chunk_index].blooms;
+	if (!blooms.empty() && bloom_valid(type)) {
+		bloom_add(blooms[column_index], bloom_hash(new_value));
+	}
+	if (m_format.columnar) {
+		auto const& chunk = m_chunks[it.chunk_index];
+		value_write(
+			new_value,
+			column_data(m_format, chunk, column_index) + it.inner_index * column_fixed_size(type),
+			false
+		);
+		return;
+	}
+
+	auto record = record_read(m_format, m_chunks[it.chunk_index].data + it.data_offset);
+	unsigned const sparse_bit = m_format.sparse_bits[column_index];
+	bool present = true;
+	unsigned const offset
+		= sparse_bit == ~0u
+		? field_offset(m_format, m_schema, record, column_index)
+		: sparse_field_offset(m_format, m_schema.columns(), record, sparse_bit, present)
+	;
+	// NB: Sparse fields are removed when set to the initial value
+	bool const new_present = sparse_bit == ~0u || !value_initial(new_value, is_dynamic);
+	unsigned const old_size = present ? value_read_size_whole(type, record.data + offset) : 0;
+	unsigned const new_size = new_present ? value_written_size(new_value, is_dynamic) : 0;
+	if (new_size != old_size) {
+		m_chunks[it.chunk_index].dirty = true;
+		unsigned const used_size = record_data_size(m_format, m_schema, record);
+		// Only resize if the new value cannot fit within the record's current size
+		if (record.size - (used_size - old_size) < new_size) {
+			Data::Table::Chunk split{};
+			if (record_resize(
+				m_format, record, m_chunks[it.chunk_index], split, it,
+				(record.size - old_size) + new_size
+			)) {
+				m_chunks.insert(it.chunk_index, split);
+				recount_chunks(max_ce(it.chunk_index, 1u) - 1, 3);
+			}
+		}
+		// Shift the fields after the value
+		std::memmove(
+			record.data + offset + new_size,
+			record.data + offset + old_size,
+			used_size - (offset + old_size)
+		);
+		unsigned slot = m_format.field_slots[column_index];
+		if (slot != ~0u) {
+			auto* const slots = record_slots(m_format, record);
+			for (++slot; slot < m_format.slot_columns.size(); ++slot) {
+				slots[slot - 1] = slots[slot - 1] - old_size + new_size;
+			}
+		}
+	}
+	if (present != new_present) {
+		auto* const bits = record.data + record_regular_size(m_format, m_schema.columns(), record);
+		bits[sparse_bit >> 3] ^= 1u << (sparse_bit & 7);
+	}
+	if (new_present) {
+		value_write(new_value, record.data + offset, is_dynamic);
+	}
+}
+
+Data::ValueRef
+Table::get_field(
+	Data::Table::Iterator const& it,
+	unsigned const column_index
+) const noexcept {
+	DUCT_ASSERTE(it.table == this);
+	if (column_index >= num_columns() || !it.can_advance()) {
+		return {};
+	}
+	auto const type = column(column_index).type;
+	if (type.type() == Data::ValueType::null) {
+		return {};
+	}
+	auto const& chunk = m_chunks.at(it.chunk_index, it.chunk_hint);
+	auto const* const version = chunk_version(m_versions, chunk);
+	auto const& format = version ? version->format : m_format;
+	auto const& schema = version ? version->schema : m_schema;
+	unsigned const version_column = version ? version->columns[column_index].index : column_index;
+	std::uint8_t const* data;
+	if (version_column == ~0u) {
+		// Appended since the chunk was written
+		data = INIT_VALUE_DATA;
+	} else if (format.columnar) {
+		data = column_data(format, chunk, version_column) + it.inner_index * column_fixed_size(type);
+	} else {
+		auto const record = record_read(format, chunk.data + it.data_offset);
+		unsigned const offset = field_offset(format, schema, record, version_column);
+		// NB: Absent sparse fields read as the initial value
+		data = offset != ~0u ? record.data + offset : INIT_VALUE_DATA;
+	}
+	auto const value = value_read(type, data);
+	return type_coded(type) ? dictionary_decode(m_dictionaries[column_index], value) : value;
+}
+
+void
+Table::get_fields(
+	Data::Table::Cursor& cursor
+) const {
+	auto const& it = cursor.it;
+	DUCT_ASSERTE(it.table == this);
+	unsigned end = min_ce(static_cast<unsigned>(cursor.mask.size()), num_columns());
+	cursor.values.assign(num_columns(), {});
+	while (0 < end && !cursor.mask[end - 1]) {
+		--end;
+	}
+	if (end == 0 || !it.can_advance()) {
+		return;
+	}
+	auto const& chunk = m_chunks.at(it.chunk_index, it.chunk_hint);
+	auto const* const version = chunk_version(m_versions, chunk);
+	auto const& format = version ? version->format : m_format;
+	auto const& schema = version ? version->schema : m_schema;
+	Record record{};
+	if (!format.stride) {
+		// NB: Fields are located up to the last column read, which
+		// may be before the end in older versions
+		unsigned version_end = 0;
+		for (unsigned index = 0; index < end; ++index) {
+			unsigned const version_column = version ? version->columns[index].index : index;
+			if (cursor.mask[index] && version_column != ~0u) {
+				version_end = max_ce(version_end, version_column + 1);
+			}
+		}
+		record = record_read(format, chunk.data + it.data_offset);
+		cursor.offsets.resize(schema.num_columns());
+		record_field_offsets(format, schema.columns(), record, version_end, cursor.offsets.data());
+	}
+	std::uint8_t const* data;
+	for (unsigned index = 0; index < end; ++index) {
+		auto const type = column(index).type;
+		unsigned const version_column = version ? version->columns[index].index : index;
+		if (!cursor.mask[index] || type.type() == Data::ValueType::null) {
+			continue;
+		} else if (version_column == ~0u) {
+			// Appended since the chunk was written
+			data = INIT_VALUE_DATA;
+		} else if (format.columnar) {
+			data = column_data(format, chunk, version_column) + it.inner_index * column_fixed_size(type);
+		} else if (format.stride) {
+			data = chunk.data + it.data_offset + format.field_offsets[version_column];
+		} else {
+			unsigned const offset = cursor.offsets[version_column];
+			data = offset != ~0u ? record.data + offset : INIT_VALUE_DATA;
+		}
+		auto& value = cursor.values[index];
+		value = value_read(type, data);
+		if (type_coded(type)) {
+			value = dictionary_decode(m_dictionaries[index], value);
+		}
+	}
+}
+
+template<class T, class S>
+struct AggregateState {
+	unsigned count{0};
+	S sum{0};
+	T min{std::numeric_limits<T>::max()};
+	T max{std::numeric_limits<T>::lowest()};
+};
+
+// NB: Lanes are independent so that contiguous runs vectorize
+template<class T, class S>
+static void
+aggregate_run(
+	AggregateState<T, S>& state,
+	std::uint8_t const* const data,
+	unsigned const step,
+	unsigned const count
+) noexcept {
+	enum : unsigned { NUM_LANES = 4 };
+	S sum[NUM_LANES]{};
+	T min[NUM_LANES];
+	T max[NUM_LANES];
+	for (unsigned lane = 0; lane < NUM_LANES; ++lane) {
+		min[lane] = state.min;
+		max[lane] = state.max;
+	}
+	unsigned index = 0;
+	T value;
+	if (step == sizeof(T)) {
+		for (; index + NUM_LANES <= count; index += NUM_LANES) {
+			for (unsigned lane = 0; lane < NUM_LANES; ++lane) {
+				std::memcpy(&value, data + (index + lane) * sizeof(T), sizeof(T));
+				sum[lane] += value;
+				min[lane] = value < min[lane] ? value : min[lane];
+				max[lane] = max[lane] < value ? value : max[lane];
+			}
+		}
+	}
+	for (; index < count; ++index) {
+		std::memcpy(&value, data + index * step, sizeof(T));
+		sum[0] += value;
+		min[0] = value < min[0] ? value : min[0];
+		max[0] = max[0] < value ? value : max[0];
+	}
+	for (unsigned lane = 0; lane < NUM_LANES; ++lane) {
+		state.sum += sum[lane];
+		state.min = min[lane] < state.min ? min[lane] : state.min;
+		state.max = state.max < max[lane] ? max[lane] : state.max;
+	}
+	state.count += count;
+}
+
+// Comparison of chunk values for zone skipping
+struct ZoneTerm {
+	Data::Table::Compare compare;
+	std::uint64_t key;
+	/** Whether key order is value order (chunks can match whole). */
+	bool exact;
+};
+
+enum class ZoneMatch : unsigned {
+	none,
+	some,
+	all,
+};
+
+static ZoneMatch
+zone_match(
+	Data::Table::Zone const& zone,
+	ZoneTerm const& term
+) noexcept {
+	if (zone.max < zone.min) {
+		return ZoneMatch::none;
+	}
+	bool none = false;
+	bool all = false;
+	switch (term.compare) {
+	case Data::Table::Compare::equal:
+		none = term.key < zone.min || zone.max < term.key;
+		all = zone.min == term.key && zone.max == term.key;
+		break;
+	case Data::Table::Compare::not_equal:
+		// NB: Inexact keys (decimals) may be NaN, which is never equal
+		none = term.exact && zone.min == term.key && zone.max == term.key;
+		all = term.key < zone.min || zone.max < term.key;
+		break;
+	case Data::Table::Compare::less:
+		none = zone.min >= term.key;
+		all = zone.max < term.key;
+		break;
+	case Data::Table::Compare::less_equal:
+		none = zone.min > term.key;
+		all = zone.max <= term.key;
+		break;
+	case Data::Table::Compare::greater:
+		none = zone.max <= term.key;
+		all = zone.min > term.key;
+		break;
+	case Data::Table::Compare::greater_equal:
+		none = zone.max < term.key;
+		all = zone.min >= term.key;
+		break;
+	}
+	return
+		  none ? ZoneMatch::none
+		: all && term.exact ? ZoneMatch::all
+		: ZoneMatch::some
+	;
+}
+
+// Equality of chunk values for filter skipping
+struct BloomTerm {
+	/** Compare::equal or Compare::not_equal. */
+	Data::Table::Compare compare;
+	std::uint64_t hash;
+};
+
+// Visit a column as runs of (data, step, count, first record index).
+// With a zone or filter term, chunks whose zones or filters rule out a
+// match are skipped and chunks that match whole are selected in bits
+// without a visit.
+template<class F>
+static void
+table_visit_column(
+	Data::Table::RecordFormat const& format,
+	Data::TableSchema const& schema,
+	Data::Table::chunk_tree_type const& chunks,
+	Data::Table::version_vector_type const& versions,
+	unsigned const column_index,
+	F&& visit,
+	ZoneTerm const* const zone_term = nullptr,
+	std::uint64_t* const bits = nullptr,
+	BloomTerm const* const bloom_term = nullptr
+) {
+	unsigned first_index = 0;
+	auto match = ZoneMatch::some;
+	for (auto const& chunk : chunks) {
+		auto const* const version = chunk_version(versions, chunk);
+		auto const& chunk_format = version ? version->format : format;
+		auto const& chunk_schema = version ? version->schema : schema;
+		unsigned const column = version ? version->columns[column_index].index : column_index;
+		if (zone_term && column != ~0u && !chunk.zones.empty()) {
+			match = zone_match(chunk.zones[column], *zone_term);
+		} else {
+			match = ZoneMatch::some;
+		}
+		if (
+			match == ZoneMatch::some &&
+			bloom_term && column < chunk.blooms.size() &&
+			!bloom_test(chunk.blooms[column], bloom_term->hash)
+		) {
+			// NB: The value is not in the chunk
+			match
+				= bloom_term->compare == Data::Table::Compare::equal
+				? ZoneMatch::none
+				: ZoneMatch::all
+			;
+		}
+		if (match == ZoneMatch::some) {
+			chunk_visit_column(chunk_format, chunk_schema, chunk, column, first_index, visit);
+		} else if (match == ZoneMatch::all) {
+			for (unsigned index = 0; index < chunk.num_records; ++index) {
+				bits[(first_index + index) >> 6] |= std::uint64_t{1} << ((first_index + index) & 63);
+			}
+		}
+		first_index += chunk.num_records;
+	}
+}
+
+template<class T, class S>
+static void
+table_aggregate(
+	Data::Table::RecordFormat const& format,
+	Data::TableSchema const& schema,
+	Data::Table::chunk_tree_type const& chunks,
+	Data::Table::version_vector_type const& versions,
+	unsigned const column_index,
+	Data::Table::Aggregate& aggregate
+) noexcept {
+	AggregateState<T, S> state{};
+	table_visit_column(
+		format, schema, chunks, versions, column_index,
+		[&state](
+			std::uint8_t const* const data,
+			unsigned const step,
+			unsigned const count,
+			unsigned const /*first_index*/
+		) {
+			aggregate_run(state, data, step, count);
+		}
+	);
+	if (0 < state.count) {
+		auto const type = schema.column(column_index).type;
+		aggregate.count = state.count;
+		aggregate.sum = {state.sum};
+		aggregate.min = {state.min};
+		aggregate.min.morph(type);
+		aggregate.max = {state.max};
+		aggregate.max.morph(type);
+	}
+}
+
+Data::Table::Aggregate
+Table::aggregate(
+	unsigned const column_index
+) const noexcept {
+	Data::Table::Aggregate aggregate{};
+	if (column_index >= num_columns()) {
+		return aggregate;
+	}
+	auto const type = column(column_index).type;
+	bool const is_signed = enum_cast(type.flags() & Data::ValueFlag::integer_signed);
+#define HORD_AGGREGATE_(T, S) \
+		table_aggregate<T, S>(m_format, m_schema, m_chunks, m_versions, column_index, aggregate)
+	switch (type.type()) {
+	case Data::ValueType::integer:
+		switch (type.size()) {
+		case Data::Size::b8:
+			if (is_signed) {
+				HORD_AGGREGATE_(std::int8_t, std::int64_t);
+			} else {
+				HORD_AGGREGATE_(std::uint8_t, std::uint64_t);
+			}
+			break;
+		case Data::Size::b16:
+			if (is_signed) {
+				HORD_AGGREGATE_(std::int16_t, std::int64_t);
+			} else {
+				HORD_AGGREGATE_(std::uint16_t, std::uint64_t);
+			}
+			break;
+		case Data::Size::b32:
+			if (is_signed) {
+				HORD_AGGREGATE_(std::int32_t, std::int64_t);
+			} else {
+				HORD_AGGREGATE_(std::uint32_t, std::uint64_t);
+			}
+			break;
+		case Data::Size::b64:
+			if (is_signed) {
+				HORD_AGGREGATE_(std::int64_t, std::int64_t);
+			} else {
+				HORD_AGGREGATE_(std::uint64_t, std::uint64_t);
+			}
+			break;
+		}
+		break;
+
+	case Data::ValueType::decimal:
+		if (type.size() == Data::Size::b64) {
+			HORD_AGGREGATE_(double, double);
+		} else {
+			HORD_AGGREGATE_(float, double);
+		}
+		break;
+
+	default:
+		break;
+	}
+#undef HORD_AGGREGATE_
+	return aggregate;
+}
+
+unsigned
+Table::Selection::count() const noexcept {
+	unsigned count = 0;
+	std::uint64_t word;
+	for (auto const chunk : bits) {
+		for (word = chunk; word; word &= word - 1) {
+			++count;
+		}
+	}
+	return count;
+}
+
+void
+Table::Selection::indices(
+	aux::vector<unsigned>& indices
+) const {
+	indices.clear();
+	std::uint64_t word;
+	for (unsigned index = 0; index < bits.size(); ++index) {
+		for (word = bits[index]; word; word &= word - 1) {
+			unsigned bit = 0;
+			while (!((word >> bit) & 1)) {
+				++bit;
+			}
+			indices.push_back((index << 6) + bit);
+		}
+	}
+}
+
+// Set selection bits for each value in a run that compares true
+template<class T, class C>
+static void
+select_run(
+	std::uint64_t* const bits,
+	std::uint8_t const* const data,
+	unsigned const step,
+	unsigned const count,
+	unsigned const first_index,
+	T const constant
+) noexcept {
+	C const compare{};
+	unsigned const value_step = step ? step : sizeof(T);
+	unsigned index = first_index;
+	T value;
+	for (unsigned inner = 0; inner < count; ++inner, ++index) {
+		std::memcpy(&value, data + inner * value_step, sizeof(T));
+		bits[index >> 6] |= std::uint64_t{compare(value, constant)} << (index & 63);
+	}
+}
+
+template<class T, class C>
+static void
+select_column(
+	Data::Table::RecordFormat const& format,
+	Data::TableSchema const& schema,
+	Data::Table::chunk_tree_type const& chunks,
+	Data::Table::version_vector_type const& versions,
+	unsigned const column_index,
+	T const constant,
+	ZoneTerm const* const zone_term,
+	BloomTerm const* const bloom_term,
+	std::uint64_t* const bits
+) {
+	table_visit_column(
+		format, schema, chunks, versions, column_index,
+		[bits, constant](
+			std::uint8_t const* const data,
+			unsigned const step,
+			unsigned const count,
+			unsigned const first_index
+		) {
+			select_run<T, C>(bits, data, step, count, first_index, constant);
+		},
+		zone_term, bits, bloom_term
+	);
+}
+
+template<class T>
+static void
+select_compare(
+	Data::Table::RecordFormat const& format,
+	Data::TableSchema const& schema,
+	Data::Table::chunk_tree_type const& chunks,
+	Data::Table::version_vector_type const& versions,
+	unsigned const column_index,
+	Data::Table::Compare const compare,
+	T const constant,
+	std::uint64_t* const bits,
+	bool const use_zones = false
+) {
+	// NB: Zone keys and filter hashes are of values of the column type
+	ZoneTerm zone_term{compare, 0, true};
+	BloomTerm bloom_term{compare, 0};
+	bool use_bloom = false;
+	if (use_zones) {
+		auto const type = schema.column(column_index).type;
+		auto const value = value_read(type, reinterpret_cast<std::uint8_t const*>(&constant));
+		zone_term.key = zone_key(value);
+		zone_term.exact = type.type() != Data::ValueType::decimal;
+		use_bloom = bloom_valid(type) && (
+			compare == Data::Table::Compare::equal ||
+			compare == Data::Table::Compare::not_equal
+		);
+		bloom_term.hash = use_bloom ? bloom_hash(value) : 0;
+	}
+	auto const* const zone = use_zones ? &zone_term : nullptr;
+	auto const* const bloom = use_bloom ? &bloom_term : nullptr;
+	switch (compare) {
+	case Data::Table::Compare::equal:
+		select_column<T, std::equal_to<T>>(format, schema, chunks, versions, column_index, constant, zone, bloom, bits); break;
+	case Data::Table::Compare::not_equal:
+		select_column<T, std::not_equal_to<T>>(format, schema, chunks, versions, column_index, constant, zone, bloom, bits); break;
+	case Data::Table::Compare::less:
+		select_column<T, std::less<T>>(format, schema, chunks, versions, column_index, constant, zone, bloom, bits); break;
+	case Data::Table::Compare::less_equal:
+		select_column<T, std::less_equal<T>>(format, schema, chunks, versions, column_index, constant, zone, bloom, bits); break;
+	case Data::Table::Compare::greater:
+		select_column<T, std::greater<T>>(format, schema, chunks, versions, column_index, constant, zone, bloom, bits); break;
+	case Data::Table::Compare::greater_equal:
+		select_column<T, std::greater_equal<T>>(format, schema, chunks, versions, column_index, constant, zone, bloom, bits); break;
+	}
+}
+
+// Whether every value compares true against a constant outside the
+// column's range (below if !above)
+inline static bool
+compare_out_of_range(
+	Data::Table::Compare const compare,
+	bool const above
+) noexcept {
+	switch (compare) {
+	case Data::Table::Compare::equal: return false;
+	case Data::Table::Compare::not_equal: return true;
+	case Data::Table::Compare::less:
+	case Data::Table::Compare::less_equal: return above;
+	case Data::Table::Compare::greater:
+	case Data::Table::Compare::greater_equal: return !above;
+	}
+	return false;
+}
+
+// Returns -1 if the value is below the range of T, 1 if it is above,
+// and 0 if constant was assigned
+template<class T>
+static signed
+integer_constant(
+	Data::ValueRef const& value,
+	T& constant
+) noexcept {
+	if (enum_cast(value.type.flags() & Data::ValueFlag::integer_signed)) {
+		std::int64_t const signed_value = value.integer_signed();
+		if (signed_value < 0) {
+			if (
+				!std::is_signed<T>::value ||
+				signed_value < static_cast<std::int64_t>(std::numeric_limits<T>::min())
+			) {
+				return -1;
+			}
+			constant = static_cast<T>(signed_value);
+			return 0;
+		}
+	}
+	std::uint64_t const unsigned_value = value.integer_unsigned();
+	if (unsigned_value > static_cast<std::uint64_t>(std::numeric_limits<T>::max())) {
+		return 1;
+	}
+	constant = static_cast<T>(unsigned_value);
+	return 0;
+}
+
+template<class T>
+static void
+select_integer(
+	Data::Table::RecordFormat const& format,
+	Data::TableSchema const& schema,
+	Data::Table::chunk_tree_type const& chunks,
+	Data::Table::version_vector_type const& versions,
+	Data::Table::Filter::Term const& term,
+	Data::Table::Selection& selection
+) {
+	T constant{};
+	signed range = 0;
+	if (term.value.type.type() == Data::ValueType::integer) {
+		range = integer_constant(term.value, constant);
+	} else {
+		auto value = term.value;
+		value.morph(schema.column(term.column).type);
+		std::memcpy(&constant, &value.data, sizeof(T));
+	}
+	if (range != 0) {
+		selection.reset(selection.num_records, compare_out_of_range(term.compare, 0 < range));
+	} else {
+		select_compare<T>(
+			format, schema, chunks, versions, term.column,
+			term.compare, constant, selection.bits.data(), true
+		);
+	}
+}
+
+template<class T>
+static void
+select_morphed(
+	Data::Table::RecordFormat const& format,
+	Data::TableSchema const& schema,
+	Data::Table::chunk_tree_type const& chunks,
+	Data::Table::version_vector_type const& versions,
+	Data::Table::Filter::Term const& term,
+	Data::Table::Selection& selection
+) {
+	auto value = term.value;
+	value.morph(schema.column(term.column).type);
+	T constant;
+	std::memcpy(&constant, &value.data, sizeof(T));
+	select_compare<T>(
+		format, schema, chunks, versions, term.column,
+		term.compare, constant, selection.bits.data(), true
+	);
+}
+
+// Lexicographic order of strings
+static signed
+string_order(
+	Data::ValueRef const& x,
+	Data::ValueRef const& y
+) noexcept {
+	signed const order
+		= min_ce(x.size, y.size) == 0 ? 0
+		: std::memcmp(x.data.string, y.data.string, min_ce(x.size, y.size))
+	;
+	if (order != 0) {
+		return order;
+	}
+	return
+		  x.size < y.size ? -1
+		: x.size > y.size ? 1
+		: 0
+	;
+}
+
+inline static bool
+compare_order(
+	Data::Table::Compare const compare,
+	signed const order
+) noexcept {
+	switch (compare) {
+	case Data::Table::Compare::equal: return order == 0;
+	case Data::Table::Compare::not_equal: return order != 0;
+	case Data::Table::Compare::less: return order < 0;
+	case Data::Table::Compare::less_equal: return order <= 0;
+	case Data::Table::Compare::greater: return order > 0;
+	case Data::Table::Compare::greater_equal: return order >= 0;
+	}
+	return false;
+}
+
+// Order of values of a column; dynamic fields are ordered by type
+// first
+static signed
+value_order(
+	Data::ValueRef const& x,
+	Data::ValueRef const& y
+) noexcept {
+	if (x.type.value() != y.type.value()) {
+		return x.type.value() < y.type.value() ? -1 : 1;
+	}
+	switch (x.type.type()) {
+	case Data::ValueType::integer:
+	case Data::ValueType::decimal:
+	case Data::ValueType::object_id: {
+		std::uint64_t const x_key = value_order_key(x);
+		std::uint64_t const y_key = value_order_key(y);
+		return x_key < y_key ? -1 : x_key > y_key ? 1 : 0;
+	}
+
+	case Data::ValueType::string:
+		return string_order(x, y);
+
+	default:
+		return 0;
+	}
+}
+
+// Order of records by their sort keys
+static signed
+keys_order(
+	Data::ValueRef const* const x,
+	Data::ValueRef const* const y,
+	unsigned const num_keys,
+	Data::Table::Order const order
+) noexcept {
+	for (unsigned index = 0; index < num_keys; ++index) {
+		signed const key_order = value_order(x[index], y[index]);
+		if (key_order != 0) {
+			return order == Data::Table::Order::descending ? -key_order : key_order;
+		}
+	}
+	return 0;
+}
+
+// NB: Variably-sized fields are never in runs
+static void
+select_string(
+	Data::Table::RecordFormat const& format,
+	Data::TableSchema const& schema,
+	Data::Table::chunk_tree_type const& chunks,
+	Data::Table::version_vector_type const& versions,
+	Data::Table::Filter::Term const& term,
+	Data::Table::Selection& selection
+) {
+	auto const type = schema.column(term.column).type;
+	auto constant = term.value;
+	constant.morph(type);
+	if (constant.type.type() != Data::ValueType::string) {
+		return;
+	}
+	auto* const bits = selection.bits.data();
+	auto const compare = term.compare;
+	// NB: Zones bound lengths, which only rule out equality
+	ZoneTerm const zone_term{compare, constant.size, false};
+	BloomTerm const bloom_term{compare, bloom_hash(constant)};
+	table_visit_column(
+		format, schema, chunks, versions, term.column,
+		[bits, type, compare, &constant](
+			std::uint8_t const* const data,
+			unsigned const /*step*/,
+			unsigned const /*count*/,
+			unsigned const index
+		) {
+			bool const match = compare_order(compare, string_order(value_read(type, data), constant));
+			bits[index >> 6] |= std::uint64_t{match} << (index & 63);
+		},
+		compare == Data::Table::Compare::equal ? &zone_term : nullptr,
+		bits,
+		(
+			compare == Data::Table::Compare::equal ||
+			compare == Data::Table::Compare::not_equal
+		) ? &bloom_term : nullptr
+	);
+}
+
+template<class T>
+static void
+select_codes(
+	Data::Table::RecordFormat const& format,
+	Data::TableSchema const& schema,
+	Data::Table::chunk_tree_type const& chunks,
+	Data::Table::version_vector_type const& versions,
+	unsigned const column_index,
+	aux::vector<std::uint8_t> const& matches,
+	std::uint64_t* const bits
+) {
+	table_visit_column(
+		format, schema, chunks, versions, column_index,
+		[bits, &matches](
+			std::uint8_t const* const data,
+			unsigned const step,
+			unsigned const count,
+			unsigned const first_index
+		) {
+			unsigned const value_step = step ? step : sizeof(T);
+			unsigned index = first_index;
+			T code;
+			for (unsigned inner = 0; inner < count; ++inner, ++index) {
+				std::memcpy(&code, data + inner * value_step, sizeof(T));
+				bits[index >> 6] |= std::uint64_t{matches[code]} << (index & 63);
+			}
+		}
+	);
+}
+
+// NB: Equality compares codes; other comparisons are evaluated once for
+// each distinct value
+static void
+select_coded(
+	Data::Table::RecordFormat const& format,
+	Data::TableSchema const& schema,
+	Data::Table::chunk_tree_type const& chunks,
+	Data::Table::version_vector_type const& versions,
+	Data::Table::Dictionary const& dictionary,
+	Data::Table::Filter::Term const& term,
+	Data::Table::Selection& selection
+) {
+	auto const type = schema.column(term.column).type;
+	auto constant = term.value;
+	constant.morph(type_decoded(type));
+	auto const compare = term.compare;
+	auto* const bits = selection.bits.data();
+	unsigned const code_size = Data::size_meta(type.size());
+	if (
+		compare == Data::Table::Compare::equal ||
+		compare == Data::Table::Compare::not_equal
+	) {
+		unsigned const code = dictionary_find(dictionary, constant);
+		if (code == ~0u) {
+			selection.reset(selection.num_records, compare == Data::Table::Compare::not_equal);
+		} else if (code_size == 1) {
+			select_compare<std::uint8_t>(
+				format, schema, chunks, versions, term.column,
+				compare, static_cast<std::uint8_t>(code), bits
+			);
+		} else if (code_size == 2) {
+			select_compare<std::uint16_t>(
+				format, schema, chunks, versions, term.column,
+				compare, static_cast<std::uint16_t>(code), bits
+			);
+		} else {
+			select_compare<std::uint32_t>(
+				format, schema, chunks, versions, term.column,
+				compare, code, bits
+			);
+		}
+		return;
+	}
+	aux::vector<std::uint8_t> matches(dictionary.values.size());
+	Data::ValueRef value{};
+	for (unsigned code = 0; code < matches.size(); ++code) {
+		auto const& string = dictionary.values[code];
+		value = {string.data(), static_cast<unsigned>(string.size())};
+		matches[code] = compare_order(compare, string_order(value, constant));
+	}
+	if (code_size == 1) {
+		select_codes<std::uint8_t>(format, schema, chunks, versions, term.column, matches, bits);
+	} else if (code_size == 2) {
+		select_codes<std::uint16_t>(format, schema, chunks, versions, term.column, matches, bits);
+	} else {
+		select_codes<std::uint32_t>(format, schema, chunks, versions, term.column, matches, bits);
+	}
+}
+
+static void
+select_dynamic(
+	Data::Table::RecordFormat const& format,
+	Data::TableSchema const& schema,
+	Data::Table::chunk_tree_type const& chunks,
+	Data::Table::version_vector_type const& versions,
+	Data::Table::Filter::Term const& term,
+	Data::Table::Selection& selection
+) {
+	bool const equal = term.compare == Data::Table::Compare::equal;
+	if (!equal && term.compare != Data::Table::Compare::not_equal) {
+		return;
+	}
+	auto* const bits = selection.bits.data();
+	auto const& constant = term.value;
+	table_visit_column(
+		format, schema, chunks, versions, term.column,
+		[bits, equal, &constant](
+			std::uint8_t const* const data,
+			unsigned const /*step*/,
+			unsigned const /*count*/,
+			unsigned const index
+		) {
+			bool const match = (value_read({Data::ValueType::dynamic}, data) == constant) == equal;
+			bits[index >> 6] |= std::uint64_t{match} << (index & 63);
+		}
+	);
+}
+
+static void
+select_term(
+	Data::Table::RecordFormat const& format,
+	Data::TableSchema const& schema,
+	Data::Table::chunk_tree_type const& chunks,
+	Data::Table::version_vector_type const& versions,
+	Data::Table::Filter::Term const& term,
+	Data::Table::Selection& selection
+) {
+	auto const type = schema.column(term.column).type;
+	bool const is_signed = enum_cast(type.flags() & Data::ValueFlag::integer_signed);
+#define HORD_SELECT_(F, T) \
+	F<T>(format, schema, chunks, versions, term, selection)
+	switch (type.type()) {
+	case Data::ValueType::null:
+		break;
+
+	case Data::ValueType::dynamic:
+		select_dynamic(format, schema, chunks, versions, term, selection);
+		break;
+
+	case Data::ValueType::integer:
+		switch (type.size()) {
+		case Data::Size::b8:
+			if (is_signed) {
+				HORD_SELECT_(select_integer, std::int8_t);
+			} else {
+				HORD_SELECT_(select_integer, std::uint8_t);
+			}
+			break;
+		case Data::Size::b16:
+			if (is_signed) {
+				HORD_SELECT_(select_integer, std::int16_t);
+			} else {
+				HORD_SELECT_(select_integer, std::uint16_t);
+			}
+			break;
+		case Data::Size::b32:
+			if (is_signed) {
+				HORD_SELECT_(select_integer, std::int32_t);
+			} else {
+				HORD_SELECT_(select_integer, std::uint32_t);
+			}
+			break;
+		case Data::Size::b64:
+			if (is_signed) {
+				HORD_SELECT_(select_integer, std::int64_t);
+			} else {
+				HORD_SELECT_(select_integer, std::uint64_t);
+			}
+			break;
+		}
+		break;
+
+	case Data::ValueType::decimal:
+		if (type.size() == Data::Size::b64) {
+			HORD_SELECT_(select_morphed, double);
+		} else {
+			HORD_SELECT_(select_morphed, float);
+		}
+		break;
+
+	case Data::ValueType::object_id:
+		HORD_SELECT_(select_morphed, Object::IDValue);
+		break;
+
+	case Data::ValueType::string:
+		select_string(format, schema, chunks, versions, term, selection);
+		break;
+	}
+#undef HORD_SELECT_
+}
+
+unsigned
+Table::select(
+	Data::Table::Filter const& filter,
+	Data::Table::Selection& selection
+) const {
+	selection.reset(m_num_records, !filter.match_any || filter.terms.empty());
+	if (empty()) {
+		return 0;
+	}
+	Data::Table::Selection term_selection{};
+	for (auto const& term : filter.terms) {
+		term_selection.reset(m_num_records, false);
+		if (term.column >= num_columns()) {
+			// Matches nothing
+		} else if (type_coded(column(term.column).type)) {
+			select_coded(
+				m_format, m_schema, m_chunks, m_versions,
+				m_dictionaries[term.column], term, term_selection
 			);
 		} else {
-			for (auto search = it + 1; search < end_new; ++search) {
-				if (search->name == it->name) {
-					HORD_THROW_FUNC(
-						ErrorCode::table_column_name_shared,
-						"column name is shared with another column"
-					);
-				}
-			}
+			select_term(m_format, m_schema, m_chunks, m_versions, term, term_selection);
 		}
-		// NB: Renamed columns are irrelevant if rewriting records
-		has_reference |= it->index != ~0u;
-		if (!rewrite_records) {
-			rewrite_records = it->index == ~0u || it->index != index;
-			if (!rewrite_records) {
-				auto const& old_column = old_columns[it->index];
-				rewrite_records = it->type != old_column.type;
-				if (!rewrite_records && !column_renamed) {
-					column_renamed = it->name != old_column.name;
-				}
+		if (filter.match_any) {
+			selection |= term_selection;
+		} else {
+			selection &= term_selection;
+		}
+	}
+	return selection.count();
+}
+
+void
+Table::index_add(
+	unsigned const index
+) noexcept {
+	if (m_index.column == ~0u && m_ordered_index.column == ~0u) {
+		return;
+	}
+	auto const it = iterator_at(index);
+	unsigned const id = record_ids_insert(m_record_ids, index);
+	index_insert(m_index, *this, it, id);
+	index_insert(m_ordered_index, *this, it, id);
+}
+
+void
+Table::index_append(
+	unsigned const first,
+	unsigned const count
+) noexcept {
+	if (m_index.column == ~0u && m_ordered_index.column == ~0u) {
+		return;
+	}
+	auto it = iterator_at(first);
+	unsigned id;
+	for (unsigned index = 0; index < count; ++index, ++it) {
+		id = record_ids_insert(m_record_ids, first + index);
+		index_insert(m_index, *this, it, id);
+		index_insert(m_ordered_index, *this, it, id);
+	}
+}
+
+void
+Table::index_remove(
+	unsigned const index
+) noexcept {
+	if (m_index.column == ~0u && m_ordered_index.column == ~0u) {
+		return;
+	}
+	auto const it = iterator_at(index);
+	unsigned const id = record_ids_at(m_record_ids, index);
+	index_remove_entry(m_index, *this, it, id);
+	index_remove_entry(m_ordered_index, *this, it, id);
+	record_ids_remove(m_record_ids, id);
+}
+
+// NB: IDs of kept records are unchanged, so only removed records are
+// read
+void
+Table::index_remove(
+	Data::Table::Selection const& selection
+) noexcept {
+	if (m_index.column == ~0u && m_ordered_index.column == ~0u) {
+		return;
+	}
+	aux::vector<unsigned> removed{};
+	selection.indices(removed);
+	for (auto& index : removed) {
+		auto const it = iterator_at(index);
+		index = record_ids_at(m_record_ids, index);
+		index_remove_entry(m_index, *this, it, index);
+		index_remove_entry(m_ordered_index, *this, it, index);
+	}
+	for (auto const id : removed) {
+		record_ids_remove(m_record_ids, id);
+	}
+}
+
+// NB: Entries are unchanged; only the order of IDs is rebuilt
+void
+Table::index_permute(
+	aux::vector<unsigned> const& permutation
+) noexcept {
+	if (m_index.column == ~0u && m_ordered_index.column == ~0u) {
+		return;
+	}
+	aux::vector<unsigned> ids{};
+	ids.reserve(m_num_records);
+	record_ids_collect(m_record_ids, m_record_ids.root, ids);
+	aux::vector<unsigned> order(permutation.size());
+	for (unsigned index = 0; index < permutation.size(); ++index) {
+		order[index] = ids[permutation[index]];
+	}
+	record_ids_assign(m_record_ids, order);
+}
+
+void
+Table::index_rebuild() noexcept {
+	if (m_index.column == ~0u && m_ordered_index.column == ~0u) {
+		m_index.records.clear();
+		m_ordered_index.records.clear();
+		m_record_ids = {};
+		return;
+	}
+	record_ids_build(m_record_ids, m_num_records);
+	index_rebuild_records(m_index, *this);
+	index_rebuild_records(m_ordered_index, *this);
+	if (m_index.column == ~0u && m_ordered_index.column == ~0u) {
+		m_record_ids = {};
+	}
+}
+
+void
+Table::set_index_column(
+	unsigned const column_index
+) noexcept {
+	m_index.column = column_index;
+	index_rebuild();
+}
+
+void
+Table::set_ordered_index_column(
+	unsigned const column_index
+) noexcept {
+	m_ordered_index.column = column_index;
+	index_rebuild();
+}
+
+bool
+Table::bloom_column(
+	unsigned const column_index
+) const noexcept {
+	return std::find(
+		m_bloom_columns.begin(), m_bloom_columns.end(), column_index
+	) != m_bloom_columns.end();
+}
+
+#define HORD_SCOPE_FUNC set_bloom_column
+bool
+Table::set_bloom_column(
+	unsigned const column_index,
+	bool const enable
+) {
+	if (
+		column_index >= num_columns() ||
+		!bloom_valid(column(column_index).type) ||
+		bloom_column(column_index) == enable
+	) {
+		return false;
+	} else if (enable) {
+		// NB: Filters are built by compaction
+		m_bloom_columns.push_back(column_index);
+		return true;
+	}
+	m_bloom_columns.erase(std::find(
+		m_bloom_columns.begin(), m_bloom_columns.end(), column_index
+	));
+	unsigned column;
+	for (auto& chunk : m_chunks) {
+		auto const* const version = chunk_version(m_versions, chunk);
+		column = version ? version->columns[column_index].index : column_index;
+		if (column < chunk.blooms.size()) {
+			chunk.blooms[column] = {};
+		}
+	}
+	return true;
+}
+#undef HORD_SCOPE_FUNC
+
+Table::Iterator
+Table::find(
+	unsigned const column_index,
+	Data::ValueRef value
+) {
+	if (column_index >= num_columns()) {
+		return end();
+	}
+	value.morph(type_decoded(column(column_index).type));
+	if (column_index == m_index.column) {
+		// NB: Hashes are unordered; the first match has the least index
+		unsigned found = ~0u;
+		auto const range = m_index.records.equal_range(value_hash(value));
+		for (auto entry = range.first; entry != range.second; ++entry) {
+			unsigned const position = record_ids_position(m_record_ids, entry->second);
+			if (
+				position < found &&
+				value_same(get_field(iterator_at(position), column_index), value)
+			) {
+				found = position;
 			}
 		}
-	}}
+		return iterator_at(found);
+	}
+	for (auto it = begin(); it.can_advance(); ++it) {
+		if (value_same(get_field(it, column_index), value)) {
+			return it;
+		}
+	}
+	return end();
+}
 
-	// NB: Must validate new before doing this
-	// Implicitly includes condition of num_old == 0
-	if (!has_reference) {
-		return replace_schema(schema);
-	} else if (!rewrite_records) {
-		if (column_renamed) {
-			// Only column names changed
-			return m_schema.assign(schema);
-		} else {
-			// No change
-			return false;
+unsigned
+Table::select_range(
+	unsigned const column_index,
+	Data::ValueRef lower,
+	Data::ValueRef upper,
+	aux::vector<unsigned>& indices
+) {
+	indices.clear();
+	if (column_index >= num_columns()) {
+		return 0;
+	}
+	auto const type = column(column_index).type;
+	if (!index_ordered(type)) {
+		return 0;
+	}
+	lower.morph(type);
+	upper.morph(type);
+	std::uint64_t const lower_key = value_order_key(lower);
+	std::uint64_t const upper_key = value_order_key(upper);
+	if (lower_key > upper_key) {
+		return 0;
+	}
+	if (column_index == m_ordered_index.column) {
+		auto const first = m_ordered_index.records.lower_bound(lower_key);
+		auto const last = m_ordered_index.records.upper_bound(upper_key);
+		for (auto entry = first; entry != last; ++entry) {
+			indices.push_back(record_ids_position(m_record_ids, entry->second));
+		}
+		std::sort(indices.begin(), indices.end());
+	} else {
+		for (auto it = begin(); it.can_advance(); ++it) {
+			std::uint64_t const key = value_order_key(get_field(it, column_index));
+			if (lower_key <= key && key <= upper_key) {
+				indices.push_back(it.index);
+			}
 		}
 	}
+	return indices.size();
+}
 
-	{// Rewrite records with new field layout
-	m_chunks.insert(m_chunks.cbegin(), Data::Table::Chunk{});
-	auto it_put = m_chunks.begin();
-	auto it_take = it_put + 1;
+// Rebuild chunks with records in the order of a permutation of their
+// indices
+static void
+table_permute_records(
+	Data::Table::RecordFormat const& format,
+	Data::TableSchema const& schema,
+	Data::Table::chunk_tree_type& chunks,
+	aux::vector<unsigned> const& permutation,
+	Data::Table::Chunk const& prototype
+) {
+	aux::vector<Record> sources{};
+	sources.reserve(permutation.size());
+	Record record;
 	unsigned offset;
-	unsigned take_count = 0;
-	unsigned accum_data_size = 0;
-	unsigned put_capacity = CHUNK_SIZE;
-	Record orig_record;
+	for (auto const& chunk : chunks) {
+		offset = chunk.offset_head();
+		for (unsigned index = 0; index < chunk.num_records; ++index) {
+			record = record_read(format, chunk.data + offset);
+			offset += record_written_size(format, record);
+			record.size = record_data_size(format, schema, record);
+			sources.push_back(record);
+		}
+	}
+
+	Data::Table::chunk_tree_type permuted{};
+	Data::Table::Chunk put{};
 	aux::vector<Record> records{};
 	records.reserve(256);
-	aux::vector<unsigned> old_offsets{num_old};
-	Data::ValueRef value;
-	for (; it_take != m_chunks.end(); ++it_take) {
-		offset = it_take->offset_head();
-		for (unsigned record_index = 0; record_index < it_take->num_records; ++record_index) {
-			orig_record = record_read(it_take->data + offset);
-			offset += record_written_size(orig_record);
-			for (
-				unsigned value_index = 0, value_offset = 0;
-				value_index < num_old;
-				++value_index
-			) {
-				old_offsets[value_index] = value_offset;
-				value_offset += value_read_size_whole(
-					old_columns[value_index].type,
-					orig_record.data + value_offset
-				);
-			}
-			records.push_back({});
-			auto& record = records.back();
-			record.data = orig_record.data;
-			record.size = 0;
-			for (auto it = new_columns.cbegin(); it < end_new; ++it) {
-				if (it->index == ~0u) {
-					record.size += value_init_size(it->type);
-				} else {
-					value = value_read(
-						old_columns[it->index].type,
-						orig_record.data + old_offsets[it->index]
-					);
-					value.morph(it->type);
-					record.size += value_written_size(
-						value,
-						it->type.type() == Data::ValueType::dynamic
-					);
-				}
-			}
-			accum_data_size += record_meta_size() + record.size;
-			if (0 < take_count && put_capacity <= accum_data_size) {
-				table_rewrite_records(
-					*it_put, records, max_ce(put_capacity, accum_data_size),
-					old_columns, new_columns, old_offsets
-				);
-				++it_put;
-				take_count = 0;
-				accum_data_size = 0;
-				put_capacity = max_ce(it_put->size, CHUNK_SIZE);
-			}
+	unsigned accum_data_size = 0;
+	unsigned num_taken = 0;
+	for (auto const index : permutation) {
+		records.push_back(sources[index]);
+		accum_data_size += record_written_size(format, sources[index]);
+		++num_taken;
+		if (CHUNK_SIZE <= accum_data_size || num_taken == permutation.size()) {
+			put = prototype;
+			table_write_records(put, records, max_ce(accum_data_size, CHUNK_SIZE), format);
+			permuted.push_back(put);
+			accum_data_size = 0;
 		}
-		++take_count;
 	}
-	if (!records.empty()) {
-		table_rewrite_records(
-			*it_put, records, max_ce(put_capacity, accum_data_size),
-			old_columns, new_columns, old_offsets
-		);
-		++it_put;
+	for (auto& chunk : chunks) {
+		chunk_free(chunk);
 	}
-	for (it_take = it_put; it_take != m_chunks.end(); ++it_take) {
-		chunk_free(*it_take);
+	chunks.swap(permuted);
+}
+
+static void
+table_permute_columns(
+	Data::Table::RecordFormat const& format,
+	Data::TableSchema::column_vector_type const& columns,
+	Data::Table::chunk_tree_type& chunks,
+	aux::vector<unsigned> const& permutation,
+	Data::Table::Chunk const& prototype
+) {
+	aux::vector<std::pair<Data::Table::Chunk const*, unsigned>> sources{};
+	sources.reserve(permutation.size());
+	for (auto const& chunk : chunks) {
+		for (unsigned index = 0; index < chunk.num_records; ++index) {
+			sources.emplace_back(&chunk, index);
+		}
+	}
+
+	Data::Table::chunk_tree_type permuted{};
+	Data::Table::Chunk put{prototype};
+	chunk_columns_allocate(format, put, 0);
+	for (auto const index : permutation) {
+		if (put.num_records == chunk_capacity(format, put)) {
+			permuted.push_back(put);
+			put = prototype;
+			chunk_columns_allocate(format, put, 0);
+		}
+		auto const& source = sources[index];
+		chunk_columns_copy(format, columns, *source.first, source.second, put, put.num_records, 1);
+		chunk_columns_set_count(format, put, put.num_records + 1);
+	}
+	permuted.push_back(put);
+	for (auto& chunk : chunks) {
+		chunk_free(chunk);
+	}
+	chunks.swap(permuted);
+}
+
+#define HORD_SCOPE_FUNC sort_by
+void
+Table::sort_by(
+	aux::vector<unsigned> const& column_indices,
+	Data::Table::Order const order
+) {
+	for (auto const column_index : column_indices) {
+		if (column_index >= num_columns()) {
+			HORD_THROW_FUNC(
+				ErrorCode::table_column_index_invalid,
+				"column index is out-of-bounds"
+			);
+		}
+	}
+	if (m_num_records < 2 || column_indices.empty()) {
+		return;
+	}
+	upgrade_chunks();
+
+	// NB: Keys reference chunk data, which is unmodified until the
+	// chunks are rebuilt
+	unsigned const num_keys = column_indices.size();
+	aux::vector<Data::ValueRef> keys(m_num_records * num_keys);
+	aux::vector<unsigned> permutation(m_num_records);
+	unsigned index = 0;
+	for (auto it = begin(); it.can_advance(); ++it, ++index) {
+		for (unsigned key = 0; key < num_keys; ++key) {
+			keys[index * num_keys + key] = get_field(it, column_indices[key]);
+		}
+		permutation[index] = index;
+	}
+	std::stable_sort(
+		permutation.begin(), permutation.end(),
+		[&keys, num_keys, order](unsigned const x, unsigned const y) {
+			return keys_order(
+				keys.data() + x * num_keys,
+				keys.data() + y * num_keys,
+				num_keys, order
+			) < 0;
+		}
+	);
+	if (std::is_sorted(permutation.begin(), permutation.end())) {
+		return;
 	}
-	m_chunks.erase(it_put, m_chunks.end());
+	if (m_format.columnar) {
+		table_permute_columns(m_format, m_schema.columns(), m_chunks, permutation, make_chunk());
+	} else {
+		table_permute_records(m_format, m_schema, m_chunks, permutation, make_chunk());
 	}
-	return m_schema.assign(schema);
+	index_permute(permutation);
 }
 #undef HORD_SCOPE_FUNC
 
-#define HORD_SCOPE_FUNC replace_schema
-bool
-Table::replace_schema(
-	Data::TableSchema const& schema
+#define HORD_SCOPE_FUNC insert_sorted
+Data::Table::Iterator
+Table::insert_sorted(
+	aux::vector<unsigned> const& column_indices,
+	Data::Table::Order const order,
+	unsigned num_fields,
+	Data::ValueRef* const fields
 ) {
-	bool changed = m_schema.assign(schema);
-	if (changed) {
-		clear();
+	unsigned const num_keys = column_indices.size();
+	num_fields = min_ce(num_columns(), num_fields);
+	aux::vector<Data::ValueRef> keys(2 * num_keys);
+	for (unsigned key = 0; key < num_keys; ++key) {
+		unsigned const column_index = column_indices[key];
+		if (column_index >= num_columns()) {
+			HORD_THROW_FUNC(
+				ErrorCode::table_column_index_invalid,
+				"column index is out-of-bounds"
+			);
+		}
+		// NB: Absent fields are inserted as initial values
+		auto& value = keys[key];
+		if (column_index < num_fields) {
+			value = fields[column_index];
+		}
+		value.morph(type_decoded(column(column_index).type));
 	}
-	return changed;
+
+	// Find the first record ordered after the new record
+	auto* const record_keys = keys.data() + num_keys;
+	unsigned first = 0;
+	unsigned count = m_num_records;
+	while (0 < count) {
+		unsigned const step = count / 2;
+		auto const it = iterator_at(first + step);
+		for (unsigned key = 0; key < num_keys; ++key) {
+			record_keys[key] = get_field(it, column_indices[key]);
+		}
+		if (keys_order(keys.data(), record_keys, num_keys, order) < 0) {
+			count = step;
+		} else {
+			first += step + 1;
+			count -= step + 1;
+		}
+	}
+	auto it = iterator_at(first);
+	insert(it, num_fields, fields);
+	return it;
+}
+#undef HORD_SCOPE_FUNC
+
+namespace {
+
+// Encoding of a column of a chunk in the serialized table
+enum class ColumnCodec : std::uint8_t {
+	// Values as they are stored
+	raw = 0,
+	// Runs of equal values
+	run_length,
+	// Bit-packed offsets from the least value
+	frame_of_reference,
+	// Bit-packed offsets from the least difference of adjacent values
+	delta,
+};
+
+// Whether the values of a column type can be encoded arithmetically
+inline static bool
+codec_integral(
+	Data::Type const type
+) noexcept {
+	switch (type.type()) {
+	case Data::ValueType::integer:
+	case Data::ValueType::object_id:
+		return true;
+	default:
+		return type_coded(type);
+	}
+}
+
+// Bit flipped so that the keys of a column order as unsigned integers
+inline static std::uint64_t
+codec_sign_bit(
+	Data::Type const type,
+	unsigned const size
+) noexcept {
+	return
+		type.type() == Data::ValueType::integer &&
+		enum_cast(type.flags() & Data::ValueFlag::integer_signed)
+		? std::uint64_t{1} << (8 * size - 1)
+		: 0
+	;
+}
+
+template<class T>
+inline static std::uint64_t
+codec_load(
+	std::uint8_t const* const data
+) noexcept {
+	T value;
+	std::memcpy(&value, data, sizeof(T));
+	return value;
+}
+
+template<class T>
+inline static void
+codec_store(
+	std::uint8_t* const data,
+	std::uint64_t const key
+) noexcept {
+	T const value = static_cast<T>(key);
+	std::memcpy(data, &value, sizeof(T));
 }
-#undef HORD_SCOPE_FUNC
 
-void
-Table::clear() noexcept {
-	for (auto& chunk : m_chunks) {
-		chunk_clear(chunk);
+// NB: Column values are at most 8 bytes
+static std::uint64_t
+codec_key(
+	std::uint8_t const* const data,
+	unsigned const size,
+	std::uint64_t const sign_bit
+) noexcept {
+	switch (size) {
+	case 1: return codec_load<std::uint8_t>(data) ^ sign_bit;
+	case 2: return codec_load<std::uint16_t>(data) ^ sign_bit;
+	case 4: return codec_load<std::uint32_t>(data) ^ sign_bit;
+	default: return codec_load<std::uint64_t>(data) ^ sign_bit;
 	}
-	m_num_records = 0;
 }
 
 static void
-table_write_records(
-	Data::Table::Chunk& chunk,
-	aux::vector<Record>& records,
-	unsigned const size
-) {
-	if (chunk.size < size) {
-		chunk_allocate(chunk, size);
-	}
-	unsigned offset = 0;
-	for (auto const& record : records) {
-		offset += record_write(record, chunk.data + offset);
+codec_value(
+	std::uint8_t* const data,
+	unsigned const size,
+	std::uint64_t const key
+) noexcept {
+	switch (size) {
+	case 1: codec_store<std::uint8_t>(data, key); break;
+	case 2: codec_store<std::uint16_t>(data, key); break;
+	case 4: codec_store<std::uint32_t>(data, key); break;
+	default: codec_store<std::uint64_t>(data, key); break;
 	}
-	chunk_set_bounds(chunk, records.size(), 0, offset);
-	records.clear();
 }
 
-void
-Table::optimize_storage() {
-	if (empty()) {
-		return;
+inline static unsigned
+codec_width(
+	std::uint64_t value
+) noexcept {
+	unsigned width = 0;
+	for (; value; value >>= 1) {
+		++width;
 	}
+	return width;
+}
 
-	m_chunks.insert(m_chunks.cbegin(), Data::Table::Chunk{});
-	auto it_put = m_chunks.begin();
-	auto it_take = it_put + 1;
-	unsigned offset;
-	unsigned take_count = 0;
-	unsigned accum_data_size = 0;
-	unsigned put_capacity = CHUNK_SIZE;
-	Record orig_record;
-	aux::vector<Record> records{};
-	records.reserve(256);
-	for (; it_take != m_chunks.end(); ++it_take) {
-		offset = it_take->offset_head();
-		for (unsigned index = 0; index < it_take->num_records; ++index) {
-			orig_record = record_read(it_take->data + offset);
-			offset += record_written_size(orig_record);
-			records.push_back({});
-			auto& record = records.back();
-			record.data = orig_record.data;
-			record.size = record_data_size(orig_record, m_schema);
-			accum_data_size += record_written_size(record);
-			if (0 < take_count && put_capacity <= accum_data_size) {
-				table_write_records(*it_put, records, max_ce(put_capacity, accum_data_size));
-				++it_put;
-				take_count = 0;
-				accum_data_size = 0;
-				put_capacity = max_ce(it_put->size, CHUNK_SIZE);
-			}
-		}
-		++take_count;
-	}
-	if (!records.empty()) {
-		table_write_records(*it_put, records, max_ce(put_capacity, accum_data_size));
-		++it_put;
-	}
-	it_take = it_put;
-	for (; it_take != m_chunks.end(); ++it_take) {
-		chunk_free(*it_take);
-	}
-	m_chunks.erase(it_put, m_chunks.end());
+inline static unsigned
+codec_packed_size(
+	unsigned const count,
+	unsigned const width
+) noexcept {
+	return static_cast<unsigned>((std::uint64_t{count} * width + 7) / 8);
 }
 
-bool
-Table::assign(
-	Data::Table const& table
-) {
-	clear();
-	bool schema_changed = replace_schema(table.schema());
-	unsigned head;
-	unsigned tail;
-	for (auto const& chunk : table.m_chunks) {
-		Data::Table::Chunk chunk_copy{};
-		head = chunk.offset_head();
-		tail = chunk.offset_tail();
-		chunk_allocate(chunk_copy, chunk.size);
-		chunk_set_bounds(chunk_copy, chunk.num_records, head, tail);
-		std::memcpy(chunk_copy.data + head, chunk.data + head, chunk.space_used());
-		m_chunks.push_back(chunk_copy);
+static void
+codec_pack(
+	aux::vector<std::uint8_t>& buffer,
+	std::uint64_t const value,
+	unsigned const width,
+	std::uint64_t& bit
+) noexcept {
+	unsigned take;
+	for (unsigned done = 0; done < width; done += take) {
+		unsigned const shift = bit & 7;
+		take = min_ce(width - done, 8 - shift);
+		buffer[bit >> 3] |= static_cast<std::uint8_t>(
+			((value >> done) & ((1u << take) - 1)) << shift
+		);
+		bit += take;
 	}
-	m_num_records = table.m_num_records;
-	return schema_changed;
 }
 
-void
-Table::insert(
-	Data::Table::Iterator& it,
-	unsigned num_fields,
-	Data::ValueRef* const fields
+static std::uint64_t
+codec_unpack(
+	aux::vector<std::uint8_t> const& buffer,
+	unsigned const width,
+	std::uint64_t& bit
 ) noexcept {
-	DUCT_ASSERTE(it.table == this);
+	std::uint64_t value = 0;
+	unsigned take;
+	for (unsigned done = 0; done < width; done += take) {
+		unsigned const shift = bit & 7;
+		take = min_ce(width - done, 8 - shift);
+		value |= static_cast<std::uint64_t>(
+			(buffer[bit >> 3] >> shift) & ((1u << take) - 1)
+		) << done;
+		bit += take;
+	}
+	return value;
+}
 
-	Record record;
-	{ // Calculate record size
-	// TODO: Cache init size
-	num_fields = min_ce(num_columns(), num_fields);
-	unsigned record_size = 0;
-	unsigned index = 0;
-	for (; index < num_fields; ++index) {
-		auto& value = fields[index];
-		auto const type = column(index).type;
-		bool const is_dynamic = type == Data::ValueType::dynamic;
-		value.morph(type);
-		record_size += max_ce(
-			value_init_size(type),
-			value_written_size(value, is_dynamic)
-		);
+// Codec of a column of a chunk
+struct ColumnPlan {
+	ColumnCodec codec;
+	unsigned width;
+	unsigned num_runs;
+	// Least value for frame-of-reference, least difference for delta
+	std::uint64_t base;
+	// Size of the encoded column, excluding the codec tag
+	std::uint64_t size;
+};
+
+// Find the codec that gives the least data for a column of a chunk
+static void
+column_plan(
+	ColumnPlan& plan,
+	Data::Type const type,
+	std::uint8_t const* const data,
+	unsigned const step,
+	unsigned const count
+) noexcept {
+	unsigned const size = column_fixed_size(type);
+	plan = {ColumnCodec::raw, 0, 0, 0, std::uint64_t{count} * size};
+	if (size == 0 || count == 0) {
+		return;
 	}
-	for (; index < num_columns(); ++index) {
-		record_size += value_init_size(column(index).type);
+	std::uint64_t const sign_bit = codec_sign_bit(type, size);
+	std::uint64_t key = codec_key(data, size, sign_bit);
+	std::uint64_t prev;
+	std::uint64_t key_min = key;
+	std::uint64_t key_max = key;
+	std::int64_t delta_min = 0;
+	std::int64_t delta_max = 0;
+	unsigned num_runs = 1;
+	for (unsigned index = 1; index < count; ++index) {
+		prev = key;
+		key = codec_key(data + index * step, size, sign_bit);
+		key_min = min_ce(key_min, key);
+		key_max = max_ce(key_max, key);
+		num_runs += key != prev;
+		// NB: Differences wrap, so the range below is exact modulo 2^64
+		auto const delta = static_cast<std::int64_t>(key - prev);
+		delta_min = index == 1 ? delta : min_ce(delta_min, delta);
+		delta_max = index == 1 ? delta : max_ce(delta_max, delta);
 	}
 
-	if (m_chunks.empty()) {
-		Data::Table::Chunk chunk{};
-		chunk_allocate(chunk, max_ce(record_written_size(record_size), CHUNK_SIZE));
-		m_chunks.push_back(chunk);
-		it = begin();
+	std::uint64_t const run_length_size
+		= sizeof(std::uint32_t)
+		+ std::uint64_t{num_runs} * (size + sizeof(std::uint32_t))
+	;
+	if (run_length_size < plan.size) {
+		plan = {ColumnCodec::run_length, 0, num_runs, 0, run_length_size};
 	}
-	// Make record
-	Data::Table::Chunk split{};
-	if (record_make(record, m_chunks[it.chunk_index], split, it, record_size)) {
-		m_chunks.insert(m_chunks.cbegin() + it.chunk_index, split);
-	}}
-
-	// Write supplied field values
-	unsigned offset = 0;
-	unsigned index = 0;
-	for (; index < num_fields; ++index) {
-		auto const& value = fields[index];
-		bool const is_dynamic = column(index).type.type() == Data::ValueType::dynamic;
-		offset += value_write(value, record.data + offset, is_dynamic);
+	if (!codec_integral(type)) {
+		return;
 	}
-	// Zero the rest of the record
-	if (index < num_columns()) {
-		std::memset(record.data + offset, 0, record.size - offset);
+	unsigned width = codec_width(key_max - key_min);
+	std::uint64_t const reference_size = 9 + codec_packed_size(count, width);
+	if (reference_size < plan.size) {
+		plan = {ColumnCodec::frame_of_reference, width, 0, key_min, reference_size};
+	}
+	width = codec_width(
+		static_cast<std::uint64_t>(delta_max) - static_cast<std::uint64_t>(delta_min)
+	);
+	std::uint64_t const delta_size = 17 + codec_packed_size(count - 1, width);
+	if (1 < count && delta_size < plan.size) {
+		plan = {
+			ColumnCodec::delta, width, 0,
+			static_cast<std::uint64_t>(delta_min), delta_size
+		};
 	}
-	++m_chunks[it.chunk_index].num_records;
-	++m_num_records;
 }
 
-void
-Table::remove(
-	Data::Table::Iterator& it
-) noexcept {
-	DUCT_ASSERTE(it.table == this);
-	if (!it.can_advance()) {
+// Write a column of a chunk with the codec from column_plan()
+static void
+column_encode(
+	OutputSerializer& ser,
+	ColumnPlan const& plan,
+	Data::Type const type,
+	std::uint8_t const* const data,
+	unsigned const step,
+	unsigned const count,
+	aux::vector<std::uint8_t>& buffer
+) {
+	unsigned const size = column_fixed_size(type);
+	if (size == 0 || count == 0) {
 		return;
 	}
-	auto& chunk = m_chunks[it.chunk_index];
-	unsigned const size = record_written_size(record_read(chunk.data + it.data_offset));
-	Data::Table::Chunk split_unused{};
-	DUCT_ASSERTE(!segment_resize(chunk, split_unused, it, size, 0));
-	--chunk.num_records;
-	--m_num_records;
-	if (chunk.num_records == 0) {
-		chunk_free(chunk);
-		m_chunks.erase(m_chunks.cbegin() + it.chunk_index);
-		if (it.chunk_index < m_chunks.size()) {
-			it.inner_index = 0;
-			it.data_offset = m_chunks[it.chunk_index].offset_head();
-		} else {
-			it = iterator_at(it.index);
+	std::uint64_t const sign_bit = codec_sign_bit(type, size);
+	std::uint8_t const codec_tag = enum_cast(plan.codec);
+	std::uint8_t const width = static_cast<std::uint8_t>(plan.width);
+	ser(codec_tag);
+	std::uint64_t bit = 0;
+	switch (plan.codec) {
+	case ColumnCodec::raw:
+		buffer.resize(count * size);
+		for (unsigned index = 0; index < count; ++index) {
+			std::memcpy(buffer.data() + index * size, data + index * step, size);
+		}
+		break;
+
+	case ColumnCodec::run_length: {
+		// NB: Run values precede run lengths
+		buffer.resize(plan.num_runs * (size + sizeof(std::uint32_t)));
+		std::uint8_t* value = buffer.data();
+		std::uint8_t* length = buffer.data() + plan.num_runs * size;
+		std::uint32_t run = 0;
+		for (unsigned index = 0; index < count; ++index) {
+			++run;
+			if (
+				index + 1 == count ||
+				std::memcmp(data + index * step, data + (index + 1) * step, size) != 0
+			) {
+				std::memcpy(value, data + index * step, size);
+				std::memcpy(length, &run, sizeof(run));
+				value += size;
+				length += sizeof(run);
+				run = 0;
+			}
+		}
+		ser(static_cast<std::uint32_t>(plan.num_runs));
+	}	break;
+
+	case ColumnCodec::frame_of_reference:
+		ser(plan.base, width);
+		buffer.assign(codec_packed_size(count, width), 0);
+		for (unsigned index = 0; index < count; ++index) {
+			codec_pack(
+				buffer, codec_key(data + index * step, size, sign_bit) - plan.base,
+				width, bit
+			);
+		}
+		break;
+
+	case ColumnCodec::delta: {
+		std::uint64_t key = codec_key(data, size, sign_bit);
+		std::uint64_t prev;
+		ser(key, plan.base, width);
+		buffer.assign(codec_packed_size(count - 1, width), 0);
+		for (unsigned index = 1; index < count; ++index) {
+			prev = key;
+			key = codec_key(data + index * step, size, sign_bit);
+			codec_pack(buffer, key - prev - plan.base, width, bit);
 		}
+	}	break;
 	}
+	ser(Cacophony::make_binary_blob(buffer.data(), buffer.size()));
 }
 
-void
-Table::set_field(
-	Data::Table::Iterator& it,
-	unsigned column_index,
-	Data::ValueRef new_value
+// Read a column of a chunk written by column_encode()
+static void
+column_decode(
+	InputSerializer& ser,
+	Data::Type const type,
+	std::uint8_t* const data,
+	unsigned const step,
+	unsigned const count,
+	aux::vector<std::uint8_t>& buffer
 ) {
-	DUCT_ASSERTE(it.table == this);
-	if (column_index >= num_columns() || !it.can_advance()) {
-		return;
-	}
-	auto const type = column(column_index).type;
-	if (type.type() == Data::ValueType::null) {
+	unsigned const size = column_fixed_size(type);
+	if (size == 0 || count == 0) {
 		return;
 	}
-	bool const is_dynamic = type.type() == Data::ValueType::dynamic;
-	new_value.morph(type);
-
-	auto record = record_read(m_chunks[it.chunk_index].data + it.data_offset);
-	unsigned const offset = field_offset(record, m_schema, column_index);
-	unsigned const old_size = value_read_size_whole(type, record.data + offset);
-	unsigned const new_size = value_written_size(new_value, is_dynamic);
-	++column_index;
-	unsigned offset_last = offset + old_size;
-	if (new_size != old_size) {
-		for (; column_index < num_columns(); ++column_index) {
-			offset_last += value_read_size_whole(column(column_index).type, record.data + offset_last);
+	std::uint64_t const sign_bit = codec_sign_bit(type, size);
+	std::uint8_t codec_tag;
+	ser(codec_tag);
+	DUCT_ASSERTE(codec_tag <= enum_cast(ColumnCodec::delta));
+	std::uint64_t bit = 0;
+	switch (static_cast<ColumnCodec>(codec_tag)) {
+	case ColumnCodec::raw:
+		buffer.resize(count * size);
+		ser(Cacophony::make_binary_blob(buffer.data(), buffer.size()));
+		for (unsigned index = 0; index < count; ++index) {
+			std::memcpy(data + index * step, buffer.data() + index * size, size);
 		}
-	}
+		break;
+
+	case ColumnCodec::run_length: {
+		std::uint32_t num_runs;
+		ser(num_runs);
+		DUCT_ASSERTE(0 < num_runs && num_runs <= count);
+		buffer.resize(num_runs * (size + sizeof(std::uint32_t)));
+		ser(Cacophony::make_binary_blob(buffer.data(), buffer.size()));
+		std::uint8_t const* value = buffer.data();
+		std::uint8_t const* length = buffer.data() + num_runs * size;
+		std::uint32_t run;
+		unsigned index = 0;
+		for (; num_runs > 0; --num_runs) {
+			std::memcpy(&run, length, sizeof(run));
+			DUCT_ASSERTE(run <= count - index);
+			for (; run > 0; --run, ++index) {
+				std::memcpy(data + index * step, value, size);
+			}
+			value += size;
+			length += sizeof(run);
+		}
+		DUCT_ASSERTE(index == count);
+	}	break;
+
+	case ColumnCodec::frame_of_reference: {
+		std::uint64_t key_min;
+		std::uint8_t width;
+		ser(key_min, width);
+		DUCT_ASSERTE(width <= 64);
+		buffer.resize(codec_packed_size(count, width));
+		ser(Cacophony::make_binary_blob(buffer.data(), buffer.size()));
+		for (unsigned index = 0; index < count; ++index) {
+			codec_value(
+				data + index * step, size,
+				(key_min + codec_unpack(buffer, width, bit)) ^ sign_bit
+			);
+		}
+	}	break;
 
-	// Only resize if the new value cannot fit within the record's current size
-	if (record.size - (offset_last - old_size) < new_size) {
-		Data::Table::Chunk split{};
-		if (record_resize(record, m_chunks[it.chunk_index], split, it, (record.size - old_size) + new_size)) {
-			m_chunks.insert(m_chunks.cbegin() + it.chunk_index, split);
+	case ColumnCodec::delta: {
+		std::uint64_t key;
+		std::uint64_t base;
+		std::uint8_t width;
+		ser(key, base, width);
+		DUCT_ASSERTE(width <= 64);
+		buffer.resize(codec_packed_size(count - 1, width));
+		ser(Cacophony::make_binary_blob(buffer.data(), buffer.size()));
+		codec_value(data, size, key ^ sign_bit);
+		for (unsigned index = 1; index < count; ++index) {
+			key += base + codec_unpack(buffer, width, bit);
+			codec_value(data + index * step, size, key ^ sign_bit);
 		}
+	}	break;
 	}
-	// Shift after if the record will be enlarged
-	std::memmove(
-		record.data + offset + new_size,
-		record.data + offset + old_size,
-		offset_last - (offset + old_size)
-	);
-	value_write(new_value, record.data + offset, is_dynamic);
 }
 
-Data::ValueRef
-Table::get_field(
-	Data::Table::Iterator const& it,
-	unsigned const column_index
-) const noexcept {
-	DUCT_ASSERTE(it.table == this);
-	if (column_index >= num_columns() || !it.can_advance()) {
-		return {};
+// Data of a column in a chunk of a fixed-size record format
+inline static std::uint8_t*
+column_field_data(
+	Data::Table::RecordFormat const& format,
+	Data::Table::Chunk const& chunk,
+	unsigned const index
+) noexcept {
+	return
+		format.columnar
+		? column_data(format, chunk, index)
+		: chunk.head + format.field_offsets[index]
+	;
+}
+
+// Distance between fields of a column in a chunk of a fixed-size record
+// format
+inline static unsigned
+column_field_step(
+	Data::Table::RecordFormat const& format,
+	Data::TableSchema::column_vector_type const& columns,
+	unsigned const index
+) noexcept {
+	return format.columnar ? column_fixed_size(columns[index].type) : format.stride;
+}
+
+// Input buffer over serialized data in memory
+class MemoryBuffer final
+	: public std::streambuf
+{
+public:
+	MemoryBuffer(
+		std::uint8_t const* const data,
+		std::size_t const size
+	) {
+		// NB: The get area is only read
+		auto* const begin = const_cast<char*>(reinterpret_cast<char const*>(data));
+		setg(begin, begin, begin + size);
 	}
-	auto const type = column(column_index).type;
-	if (type.type() == Data::ValueType::null) {
-		return {};
+
+protected:
+	pos_type
+	seekoff(
+		off_type const offset,
+		std::ios_base::seekdir const dir,
+		std::ios_base::openmode const which
+	) override {
+		char* const base
+			= dir == std::ios_base::beg ? eback()
+			: dir == std::ios_base::cur ? gptr()
+			: egptr()
+		;
+		if (
+			!(which & std::ios_base::in) ||
+			offset < eback() - base ||
+			offset > egptr() - base
+		) {
+			return pos_type(off_type(-1));
+		}
+		setg(eback(), base + offset, egptr());
+		return pos_type(gptr() - eback());
 	}
-	auto const& chunk = m_chunks[it.chunk_index];
-	auto const record = record_read(chunk.data + it.data_offset);
-	unsigned const offset = field_offset(record, m_schema, column_index);
-	return value_read(type, record.data + offset);
-}
 
-// TODO: Format versioning
+	pos_type
+	seekpos(
+		pos_type const position,
+		std::ios_base::openmode const which
+	) override {
+		return seekoff(off_type(position), std::ios_base::beg, which);
+	}
+};
+
+} // anonymous namespace
+
 #define HORD_SCOPE_FUNC read
-ser_result_type
-Table::read(
-	ser_tag_read,
-	InputSerializer& ser
+void
+Table::read_impl(
+	InputSerializer& ser,
+	std::streambuf* const mapped_buffer,
+	std::uint8_t const* const mapped_data
 ) {
 	free_chunks();
 
 	std::uint32_t format_version;
 	ser(format_version);
-	DUCT_ASSERTE(format_version == 0);
+	DUCT_ASSERTE(format_version <= 9);
 	ser(m_schema);
+	// NB: Like the indexed columns, filtered columns are kept
+	m_bloom_columns.erase(
+		std::remove_if(
+			m_bloom_columns.begin(), m_bloom_columns.end(),
+			[this](unsigned const column_index) {
+				return
+					column_index >= num_columns() ||
+					!bloom_valid(column(column_index).type)
+				;
+			}
+		),
+		m_bloom_columns.end()
+	);
+	std::uint8_t layout = enum_cast(Data::Table::Layout::sequential);
+	if (1 <= format_version) {
+		ser(layout);
+		DUCT_ASSERTE(layout <= enum_cast(
+			3 <= format_version
+			? Data::Table::Layout::columnar
+			: Data::Table::Layout::indexed
+		));
+	}
+	std::uint8_t compact = 0;
+	if (7 <= format_version) {
+		ser(compact);
+	}
+	// NB: Records in fixed-size schemas had headers before version 2
+	record_format_build(
+		m_format,
+		static_cast<Data::Table::Layout>(layout),
+		compact != 0,
+		m_schema.columns(),
+		2 <= format_version
+	);
+	dictionaries_build(m_dictionaries, m_schema.columns());
+	if (4 <= format_version) {
+		std::uint32_t num_values;
+		for (unsigned index = 0; index < m_dictionaries.size(); ++index) {
+			if (!type_coded(m_schema.column(index).type)) {
+				continue;
+			}
+			auto& dictionary = m_dictionaries[index];
+			ser(num_values);
+			DUCT_ASSERTE(0 < num_values);
+			dictionary.values.resize(num_values);
+			for (unsigned code = 0; code < num_values; ++code) {
+				auto& value = dictionary.values[code];
+				ser(Cacophony::make_string_cfg<std::uint32_t>(value));
+				if (0 < code) {
+					dictionary.codes.emplace(
+						dictionary_hash({value.data(), static_cast<unsigned>(value.size())}),
+						code
+					);
+				}
+			}
+		}
+	}
 
 	std::uint32_t num_chunks;
 	ser(num_chunks);
-	m_chunks.reserve(num_chunks);
 
+	auto const& columns = m_schema.columns();
+	aux::vector<std::uint8_t> buffer;
 	std::uint32_t num_records;
 	std::uint32_t data_size;
+	std::uint8_t encoded;
+	std::uint8_t has_zones;
+	std::uint8_t has_blooms;
+	std::uint32_t num_values;
+	std::uint32_t num_words;
 	for (; num_chunks > 0; --num_chunks) {
-		Data::Table::Chunk chunk{};
+		Data::Table::Chunk chunk = make_chunk();
 		ser(num_records, data_size);
-		chunk_allocate(chunk, max_ce(data_size, CHUNK_SIZE));
-		chunk_set_bounds(chunk, num_records, 0, data_size);
-		ser(Cacophony::make_binary_blob(chunk.head, data_size));
+		// NB: Zones of older versions are built by compaction
+		has_zones = 0;
+		if (8 <= format_version) {
+			ser(has_zones);
+		}
+		if (has_zones) {
+			chunk.zones.assign(columns.size(), {});
+			for (unsigned index = 0; index < columns.size(); ++index) {
+				if (zone_column(columns[index].type)) {
+					ser(chunk.zones[index].min, chunk.zones[index].max);
+				}
+			}
+		}
+		has_blooms = 0;
+		if (9 <= format_version) {
+			ser(has_blooms);
+		}
+		if (has_blooms) {
+			chunk.blooms.resize(columns.size());
+			for (unsigned index = 0; index < columns.size(); ++index) {
+				if (!bloom_valid(columns[index].type)) {
+					continue;
+				}
+				auto& bloom = chunk.blooms[index];
+				ser(num_values, num_words);
+				bloom.num_values = num_values;
+				bloom.bits.resize(num_words);
+				for (auto& word : bloom.bits) {
+					ser(word);
+				}
+			}
+		}
+		// NB: Chunks of fixed-size records were always column-encoded
+		// in version 5
+		encoded = m_format.stride && 5 <= format_version;
+		if (encoded && 6 <= format_version) {
+			ser(encoded);
+		}
+		if (encoded) {
+			DUCT_ASSERTE(data_size == num_records * m_format.stride);
+			if (m_format.columnar) {
+				chunk_columns_allocate(m_format, chunk, num_records);
+				chunk_columns_set_count(m_format, chunk, num_records);
+			} else {
+				chunk_allocate(chunk, max_ce(data_size, CHUNK_SIZE));
+				chunk_set_bounds(chunk, num_records, 0, data_size);
+			}
+			for (unsigned index = 0; index < columns.size(); ++index) {
+				column_decode(
+					ser, columns[index].type,
+					column_field_data(m_format, chunk, index),
+					column_field_step(m_format, columns, index),
+					num_records, buffer
+				);
+			}
+		} else if (mapped_buffer) {
+			// NB: Column arrays are written in order, without slack, so
+			// the data of any layout is borrowed as it is
+			DUCT_ASSERTE(!m_format.stride || data_size == num_records * m_format.stride);
+			auto const offset = static_cast<std::streamoff>(mapped_buffer->pubseekoff(
+				0, std::ios_base::cur, std::ios_base::in
+			));
+			if (
+				data_size == 0 ||
+				mapped_buffer->pubseekoff(
+					data_size, std::ios_base::cur, std::ios_base::in
+				) == std::streampos(std::streamoff(-1))
+			) {
+				HORD_THROW_FUNC(
+					ErrorCode::serialization_data_malformed,
+					"chunk data extends past the mapped data"
+				);
+			}
+			// NB: Borrowed data is never written to
+			chunk.data = const_cast<std::uint8_t*>(mapped_data) + offset;
+			chunk.size = data_size;
+			chunk.refs = new std::atomic<unsigned>{1};
+			chunk.borrowed = true;
+			if (m_format.columnar) {
+				chunk_columns_set_count(m_format, chunk, num_records);
+			} else {
+				chunk_set_bounds(chunk, num_records, 0, data_size);
+			}
+		} else if (m_format.columnar) {
+			// NB: Column arrays are written in order, without slack
+			DUCT_ASSERTE(data_size == num_records * m_format.stride);
+			chunk_columns_allocate(m_format, chunk, num_records);
+			chunk_columns_set_count(m_format, chunk, num_records);
+			for (unsigned index = 0; index < columns.size(); ++index) {
+				ser(Cacophony::make_binary_blob(
+					column_data(m_format, chunk, index),
+					num_records * column_fixed_size(columns[index].type)
+				));
+			}
+		} else {
+			chunk_allocate(chunk, max_ce(data_size, CHUNK_SIZE));
+			chunk_set_bounds(chunk, num_records, 0, data_size);
+			ser(Cacophony::make_binary_blob(chunk.head, data_size));
+		}
 		m_num_records += chunk.num_records;
 		m_chunks.push_back(chunk);
 	}
+	if (format_version < 2) {
+		RecordFormat format{};
+		record_format_build(format, m_format.layout, m_format.compact, m_schema.columns());
+		if (format.stride) {
+			migrate(format, m_schema.columns(), m_dictionaries);
+		}
+	}
+	index_rebuild();
+}
+
+ser_result_type
+Table::read(
+	ser_tag_read,
+	InputSerializer& ser
+) {
+	read_impl(ser, nullptr, nullptr);
+}
+#undef HORD_SCOPE_FUNC
+
+#define HORD_SCOPE_FUNC read_mapped
+std::size_t
+Table::read_mapped(
+	std::uint8_t const* const data,
+	std::size_t const size
+) {
+	MemoryBuffer buffer{data, size};
+	std::istream stream{&buffer};
+	auto ser = make_input_serializer(stream);
+	read_impl(ser, &buffer, data);
+	return static_cast<std::size_t>(static_cast<std::streamoff>(
+		buffer.pubseekoff(0, std::ios_base::cur, std::ios_base::in)
+	));
 }
 #undef HORD_SCOPE_FUNC
 
+void
+Table::release_mapped() noexcept {
+	// NB: Chunks of older versions are copied by upgrading them
+	upgrade_chunks();
+	for (auto& chunk : m_chunks) {
+		if (chunk.borrowed) {
+			chunk_unshare(m_format, m_schema.columns(), chunk);
+		}
+	}
+}
+
 #define HORD_SCOPE_FUNC write
 ser_result_type
 Table::write(
 	ser_tag_write,
 	OutputSerializer& ser
 ) const {
-	const_cast<Data::Table*>(this)->optimize_storage();
-	std::uint32_t const format_version = 0;
+	// NB: Chunks are otherwise written as they are
+	const_cast<Data::Table*>(this)->compact_storage();
+	std::uint32_t const format_version = 9;
 	ser(format_version);
 	ser(m_schema);
+	std::uint8_t const layout = enum_cast(m_format.layout);
+	std::uint8_t const compact = m_format.compact;
+	ser(layout, compact);
+	for (unsigned index = 0; index < m_dictionaries.size(); ++index) {
+		if (!type_coded(m_schema.column(index).type)) {
+			continue;
+		}
+		auto const& dictionary = m_dictionaries[index];
+		ser(static_cast<std::uint32_t>(dictionary.values.size()));
+		for (auto const& value : dictionary.values) {
+			ser(Cacophony::make_string_cfg<std::uint32_t>(value));
+		}
+	}
 
-	ser(static_cast<std::uint32_t>(m_chunks.size()));
+	// NB: Only an empty table can have an empty chunk
+	ser(static_cast<std::uint32_t>(empty() ? 0 : m_chunks.size()));
+	if (empty()) {
+		return;
+	}
+	auto const& columns = m_schema.columns();
+	aux::vector<ColumnPlan> plans(columns.size());
+	aux::vector<std::uint8_t> buffer;
 	std::uint32_t num_records;
 	std::uint32_t data_size;
+	std::uint64_t encoded_size;
+	std::uint8_t encoded;
+	std::uint8_t has_zones;
+	std::uint8_t has_blooms;
+	std::uint32_t num_values;
+	std::uint32_t num_words;
 	for (auto const& chunk : m_chunks) {
 		num_records = static_cast<std::uint32_t>(chunk.num_records);
 		data_size = static_cast<std::uint32_t>(chunk.space_used());
 		ser(num_records, data_size);
-		ser(Cacophony::make_binary_blob(chunk.head, data_size));
+		has_zones = !chunk.zones.empty();
+		ser(has_zones);
+		for (unsigned index = 0; has_zones && index < columns.size(); ++index) {
+			if (zone_column(columns[index].type)) {
+				ser(chunk.zones[index].min, chunk.zones[index].max);
+			}
+		}
+		has_blooms = !chunk.blooms.empty();
+		ser(has_blooms);
+		for (unsigned index = 0; has_blooms && index < columns.size(); ++index) {
+			if (!bloom_valid(columns[index].type)) {
+				continue;
+			}
+			auto const& bloom = chunk.blooms[index];
+			num_values = static_cast<std::uint32_t>(bloom.num_values);
+			num_words = static_cast<std::uint32_t>(bloom.bits.size());
+			ser(num_values, num_words);
+			for (auto const word : bloom.bits) {
+				ser(word);
+			}
+		}
+		if (!m_format.stride) {
+			ser(Cacophony::make_binary_blob(chunk.head, data_size));
+			continue;
+		}
+		// NB: Fixed-size records are written by column so each column
+		// can take the codec that suits its values in the chunk. Chunks
+		// that barely shrink are written as they are stored so that
+		// read_mapped() can borrow them.
+		encoded_size = 0;
+		for (unsigned index = 0; index < columns.size(); ++index) {
+			column_plan(
+				plans[index], columns[index].type,
+				column_field_data(m_format, chunk, index),
+				column_field_step(m_format, columns, index),
+				num_records
+			);
+			encoded_size += sizeof(encoded) + plans[index].size;
+		}
+		encoded = encoded_size < data_size - data_size / CHUNK_ENCODE_DIVISOR;
+		ser(encoded);
+		if (encoded) {
+			for (unsigned index = 0; index < columns.size(); ++index) {
+				column_encode(
+					ser, plans[index], columns[index].type,
+					column_field_data(m_format, chunk, index),
+					column_field_step(m_format, columns, index),
+					num_records, buffer
+				);
+			}
+		} else if (m_format.columnar) {
+			for (unsigned index = 0; index < columns.size(); ++index) {
+				ser(Cacophony::make_binary_blob(
+					column_data(m_format, chunk, index),
+					num_records * column_fixed_size(columns[index].type)
+				));
+			}
+		} else {
+			ser(Cacophony::make_binary_blob(chunk.head, data_size));
+		}
 	}
 }
 #undef HORD_SCOPE_FUNC
@@ -1,5 +1,6 @@
 
 #include <Hord/String.hpp>
+#include <Hord/serialization.hpp>
 #include <Hord/Error.hpp>
 #include <Hord/ErrorCode.hpp>
 #include <Hord/utility.hpp>
@@ -10,6 +11,13 @@
 
 #include <duct/debug.hpp>
 
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <sstream>
+#include <thread>
+
 using namespace Hord;
 
 bool
@@ -24,8 +32,2016 @@ value_equal(
 	return value == it.get_field(col);
 }
 
+bool
+decimal_near(
+	double const x,
+	double const y
+) {
+	return std::abs(x - y) < 1e-9;
+}
+
+void
+round_trip(
+	Data::Table& table,
+	Data::Table& result
+) {
+	std::stringstream stream;
+	auto ser_out = make_output_serializer(stream);
+	ser_out(table);
+	auto ser_in = make_input_serializer(stream);
+	ser_in(result);
+}
+
+void
+test_layout(
+	Data::Table::Layout const layout
+) {
+	Data::TableSchema const schema{
+		{"name", {Data::ValueType::string, Data::Size::b8}},
+		{"x", {Data::ValueType::integer, Data::Size::b32}},
+		{"value", {Data::ValueType::dynamic}},
+		{"y", {Data::ValueType::decimal, Data::Size::b64}},
+		{"tag", {Data::ValueType::string, Data::Size::b16}}
+	};
+	Data::Table table{schema};
+	table.set_layout(layout);
+	DUCT_ASSERTE(table.layout() == layout);
+
+	unsigned const count = 0x400;
+	Data::ValueRef values[5];
+	for (unsigned index = 0; index < count; ++index) {
+		values[0] = {"name"};
+		values[1] = {static_cast<std::uint32_t>(index)};
+		values[2] = {static_cast<std::int16_t>(-signed_cast(index))};
+		values[3] = {static_cast<double>(index) * 0.5};
+		values[4] = {"t"};
+		table.push_back(index % 3 == 0 ? 2 : 5, values);
+	}
+	String const str(200, 'V');
+	for (unsigned index = 0; index < count; index += 7) {
+		auto it = table.iterator_at(index);
+		it.set_field(0, {str});
+		it.set_field(2, {"dynamic"});
+		it.set_field(4, {str});
+	}
+	for (unsigned index = 0; index < count; index += 14) {
+		auto it = table.iterator_at(index);
+		it.set_field(0, {"short"});
+	}
+	auto it = table.begin();
+	for (unsigned index = 0; it.can_advance(); ++it, ++index) {
+		bool const full = index % 3 != 0;
+		DUCT_ASSERTE(it.get_field(1) == Data::ValueRef{static_cast<std::uint32_t>(index)});
+		if (index % 14 == 0) {
+			DUCT_ASSERTE(it.get_field(0) == Data::ValueRef{"short"});
+		} else if (index % 7 == 0) {
+			DUCT_ASSERTE(it.get_field(0) == Data::ValueRef{str});
+		} else {
+			DUCT_ASSERTE(it.get_field(0) == Data::ValueRef{"name"});
+		}
+		if (index % 7 == 0) {
+			DUCT_ASSERTE(it.get_field(2) == Data::ValueRef{"dynamic"});
+			DUCT_ASSERTE(it.get_field(4) == Data::ValueRef{str});
+		} else if (full) {
+			DUCT_ASSERTE(it.get_field(2) == Data::ValueRef{static_cast<std::int16_t>(-signed_cast(index))});
+			DUCT_ASSERTE(it.get_field(4) == Data::ValueRef{"t"});
+		} else {
+			DUCT_ASSERTE(it.get_field(2).type.type() == Data::ValueType::null);
+			DUCT_ASSERTE(it.get_field(4) == Data::ValueRef{""});
+		}
+		DUCT_ASSERTE(it.get_field(3) == Data::ValueRef{full ? static_cast<double>(index) * 0.5 : 0.0});
+	}
+
+	table.optimize_storage();
+	DUCT_ASSERTE(value_equal(table, 7, 4, {str}));
+	table.set_layout(
+		layout == Data::Table::Layout::sequential
+		? Data::Table::Layout::indexed
+		: Data::Table::Layout::sequential
+	);
+	DUCT_ASSERTE(value_equal(table, 7, 0, {str}));
+	DUCT_ASSERTE(value_equal(table, 8, 2, {static_cast<std::int16_t>(-8)}));
+	DUCT_ASSERTE(value_equal(table, 8, 4, {"t"}));
+
+	Data::Table copy{};
+	round_trip(table, copy);
+	DUCT_ASSERTE(copy.layout() == table.layout());
+	DUCT_ASSERTE(copy.num_records() == count);
+	DUCT_ASSERTE(value_equal(copy, 7, 0, {str}));
+	DUCT_ASSERTE(value_equal(copy, count - 1, 1, {static_cast<std::uint32_t>(count - 1)}));
+}
+
+void
+test_stride() {
+	Data::TableSchema schema{
+		{"t", {Data::ValueType::integer, Data::Size::b64}},
+		{"x", {Data::ValueType::decimal, Data::Size::b32}},
+		{"id", {Data::ValueType::object_id}}
+	};
+	Data::Table table{schema};
+	unsigned const stride = 8 + 4 + sizeof(Object::IDValue);
+	DUCT_ASSERTE(table.record_stride() == stride);
+
+	unsigned const count = 0x1000;
+	Data::ValueRef values[3];
+	for (unsigned index = 0; index < count; ++index) {
+		values[0] = {static_cast<std::uint64_t>(index)};
+		values[1] = {static_cast<float>(index)};
+		values[2] = {Object::ID{index}};
+		table.push_back(3, values);
+	}
+	auto it = table.iterator_at(count / 2);
+	it.remove();
+	values[0] = {static_cast<std::uint64_t>(count / 2)};
+	it.insert(1, values);
+	DUCT_ASSERTE(value_equal(table, count / 2, 2, {Object::ID{0}}));
+	it = table.iterator_at(count / 2);
+	it.set_field(2, {Object::ID{count / 2}});
+	it.set_field(1, {static_cast<float>(count / 2)});
+	for (unsigned index = 0; index < count; index += 13) {
+		DUCT_ASSERTE(value_equal(table, index, 0, {static_cast<std::uint64_t>(index)}));
+		DUCT_ASSERTE(value_equal(table, index, 1, {static_cast<float>(index)}));
+		DUCT_ASSERTE(value_equal(table, index, 2, {Object::ID{index}}));
+	}
+
+	// Adding a string column requires record headers
+	auto& columns = schema.columns();
+	for (unsigned index = 0; index < columns.size(); ++index) {
+		columns[index].index = index;
+	}
+	columns.push_back({"s", {Data::ValueType::string, Data::Size::b8}});
+	schema.update();
+	DUCT_ASSERTE(table.configure(schema));
+	DUCT_ASSERTE(table.record_stride() == 0);
+	DUCT_ASSERTE(value_equal(table, 100, 1, {static_cast<float>(100)}));
+	DUCT_ASSERTE(value_equal(table, 100, 3, {""}));
+
+	columns.pop_back();
+	schema.update();
+	DUCT_ASSERTE(table.configure(schema));
+	DUCT_ASSERTE(table.record_stride() == stride);
+	DUCT_ASSERTE(value_equal(table, 100, 2, {Object::ID{100}}));
+
+	Data::Table copy{};
+	round_trip(table, copy);
+	DUCT_ASSERTE(copy.record_stride() == stride);
+	DUCT_ASSERTE(copy.num_records() == count);
+	DUCT_ASSERTE(value_equal(copy, count - 1, 0, {static_cast<std::uint64_t>(count - 1)}));
+
+	table.clear();
+	round_trip(table, copy);
+	DUCT_ASSERTE(copy.empty());
+}
+
+void
+test_columnar() {
+	Data::TableSchema schema{
+		{"t", {Data::ValueType::integer, Data::Size::b64}},
+		{"x", {Data::ValueType::decimal, Data::Size::b32}},
+		{"f", {Data::ValueType::integer, Data::Size::b8}}
+	};
+	Data::Table table{schema};
+	DUCT_ASSERTE(table.set_layout(Data::Table::Layout::columnar));
+	DUCT_ASSERTE(table.columnar());
+
+	// Inserting at the front splits full chunks
+	unsigned const count = 0x1000;
+	Data::ValueRef values[3];
+	for (unsigned index = count; index-- > 0;) {
+		values[0] = {static_cast<std::uint64_t>(index)};
+		values[1] = {static_cast<float>(index)};
+		auto it = table.begin();
+		it.insert(2, values);
+	}
+	DUCT_ASSERTE(table.num_records() == count);
+	auto it = table.iterator_at(7);
+	it.remove();
+	values[0] = {static_cast<std::uint64_t>(7)};
+	values[1] = {static_cast<float>(7)};
+	it.insert(2, values);
+	it.set_field(2, {static_cast<std::uint8_t>(1)});
+	DUCT_ASSERTE(value_equal(table, 7, 2, {static_cast<std::uint8_t>(1)}));
+	DUCT_ASSERTE(value_equal(table, 8, 2, {static_cast<std::uint8_t>(0)}));
+	for (unsigned index = 0; index < count; index += 13) {
+		DUCT_ASSERTE(value_equal(table, index, 0, {static_cast<std::uint64_t>(index)}));
+		DUCT_ASSERTE(value_equal(table, index, 1, {static_cast<float>(index)}));
+	}
+
+	// A string column falls back to row storage
+	auto& columns = schema.columns();
+	for (unsigned index = 0; index < columns.size(); ++index) {
+		columns[index].index = index;
+	}
+	columns.push_back({"s", {Data::ValueType::string, Data::Size::b8}});
+	schema.update();
+	DUCT_ASSERTE(table.configure(schema));
+	DUCT_ASSERTE(!table.columnar());
+	DUCT_ASSERTE(table.layout() == Data::Table::Layout::columnar);
+	DUCT_ASSERTE(value_equal(table, 7, 2, {static_cast<std::uint8_t>(1)}));
+
+	columns.pop_back();
+	schema.update();
+	DUCT_ASSERTE(table.configure(schema));
+	DUCT_ASSERTE(table.columnar());
+	DUCT_ASSERTE(value_equal(table, 100, 1, {static_cast<float>(100)}));
+
+	Data::Table copy{};
+	round_trip(table, copy);
+	DUCT_ASSERTE(copy.columnar());
+	DUCT_ASSERTE(copy.num_records() == count);
+	DUCT_ASSERTE(value_equal(copy, count - 1, 0, {static_cast<std::uint64_t>(count - 1)}));
+	DUCT_ASSERTE(value_equal(copy, 7, 2, {static_cast<std::uint8_t>(1)}));
+	copy.assign(table);
+	DUCT_ASSERTE(value_equal(copy, 7, 2, {static_cast<std::uint8_t>(1)}));
+
+	DUCT_ASSERTE(table.set_layout(Data::Table::Layout::sequential));
+	DUCT_ASSERTE(!table.columnar());
+	DUCT_ASSERTE(value_equal(table, 300, 0, {static_cast<std::uint64_t>(300)}));
+}
+
+void
+test_aggregate(
+	Data::Table::Layout const layout
+) {
+	Data::TableSchema schema{
+		{"s", {Data::ValueType::integer, Data::ValueFlag::integer_signed, Data::Size::b16}},
+		{"u", {Data::ValueType::integer, Data::Size::b32}},
+		{"x", {Data::ValueType::decimal, Data::Size::b64}},
+		{"n", {Data::ValueType::string}}
+	};
+	Data::Table table{schema};
+	table.set_layout(layout);
+	DUCT_ASSERTE(table.aggregate(0).count == 0);
+
+	unsigned const count = 0x800;
+	Data::ValueRef values[3];
+	for (unsigned index = 0; index < count; ++index) {
+		values[0] = {static_cast<std::int16_t>(static_cast<signed>(index) - 1000)};
+		values[1] = {static_cast<std::uint32_t>(index * 3)};
+		values[2] = {static_cast<double>(index) / 2.0};
+		table.push_back(3, values);
+	}
+	auto aggregate = table.aggregate(0);
+	DUCT_ASSERTE(aggregate.count == count);
+	DUCT_ASSERTE(aggregate.min.integer_signed() == -1000);
+	DUCT_ASSERTE(aggregate.max.integer_signed() == count - 1001);
+	DUCT_ASSERTE(aggregate.sum.integer_signed() == (count * (count - 1)) / 2 - 1000 * signed{count});
+	aggregate = table.aggregate(1);
+	DUCT_ASSERTE(aggregate.max.integer_unsigned() == (count - 1) * 3);
+	DUCT_ASSERTE(decimal_near(aggregate.mean(), (count - 1) * 3 / 2.0));
+	aggregate = table.aggregate(2);
+	DUCT_ASSERTE(decimal_near(aggregate.min.decimal(), 0.0));
+	DUCT_ASSERTE(decimal_near(aggregate.sum.decimal(), (count * (count - 1)) / 4.0));
+	DUCT_ASSERTE(table.aggregate(3).count == 0);
+
+	// Fixed-size columns only
+	schema.columns().pop_back();
+	schema.update();
+	table.replace_schema(schema);
+	table.set_layout(Data::Table::Layout::columnar);
+	for (unsigned index = 0; index < count; ++index) {
+		values[1] = {static_cast<std::uint32_t>(index)};
+		table.push_back(3, values);
+	}
+	aggregate = table.aggregate(1);
+	DUCT_ASSERTE(aggregate.count == count);
+	DUCT_ASSERTE(aggregate.sum.integer_unsigned() == (count * (count - 1)) / 2);
+}
+
+void
+test_select(
+	Data::Table::Layout const layout
+) {
+	Data::TableSchema schema{
+		{"s", {Data::ValueType::integer, Data::ValueFlag::integer_signed, Data::Size::b16}},
+		{"u", {Data::ValueType::integer, Data::Size::b8}},
+		{"x", {Data::ValueType::decimal, Data::Size::b32}},
+		{"n", {Data::ValueType::string}}
+	};
+	if (layout == Data::Table::Layout::columnar) {
+		schema.columns().pop_back();
+		schema.update();
+	}
+	Data::Table table{schema};
+	table.set_layout(layout);
+
+	unsigned const count = 0x400;
+	String const names[]{"a", "b", "ab"};
+	Data::ValueRef values[4];
+	for (unsigned index = 0; index < count; ++index) {
+		values[0] = {static_cast<std::int16_t>(static_cast<signed>(index) - 100)};
+		values[1] = {static_cast<std::uint8_t>(index & 0xFF)};
+		values[2] = {static_cast<float>(index) / 4.0f};
+		values[3] = {names[index % 3]};
+		table.push_back(4, values);
+	}
+
+	using Compare = Data::Table::Compare;
+	Data::Table::Filter filter{};
+	Data::Table::Selection selection{};
+	aux::vector<unsigned> indices{};
+	DUCT_ASSERTE(table.select(filter, selection) == count);
+
+	filter.terms.push_back({0, Compare::less, {static_cast<std::int64_t>(-90)}});
+	DUCT_ASSERTE(table.select(filter, indices) == 10);
+	DUCT_ASSERTE(indices.front() == 0 && indices.back() == 9);
+
+	filter.terms.push_back({2, Compare::greater_equal, {1.0f}});
+	DUCT_ASSERTE(table.select(filter, indices) == 6);
+	DUCT_ASSERTE(indices.front() == 4);
+
+	filter.match_any = true;
+	DUCT_ASSERTE(table.select(filter, selection) == count);
+
+	// Out-of-range constants
+	filter.match_any = false;
+	filter.terms.clear();
+	filter.terms.push_back({1, Compare::less, {static_cast<std::uint32_t>(300)}});
+	DUCT_ASSERTE(table.select(filter, selection) == count);
+	filter.terms[0] = {1, Compare::equal, {static_cast<std::int32_t>(-1)}};
+	DUCT_ASSERTE(table.select(filter, selection) == 0);
+	filter.terms[0] = {1, Compare::equal, {static_cast<std::uint8_t>(7)}};
+	DUCT_ASSERTE(table.select(filter, selection) == count / 0x100);
+	DUCT_ASSERTE(selection.test(7) && selection.test(0x107) && !selection.test(8));
+
+	if (layout != Data::Table::Layout::columnar) {
+		filter.terms[0] = {3, Compare::equal, {"ab"}};
+		DUCT_ASSERTE(table.select(filter, indices) == count / 3);
+		DUCT_ASSERTE(indices[0] == 2 && indices[1] == 5);
+		filter.terms[0] = {3, Compare::greater, {"a"}};
+		DUCT_ASSERTE(table.select(filter, selection) == count - (count + 2) / 3);
+	}
+}
+
+void
+test_append(
+	Data::Table::Layout const layout
+) {
+	Data::TableSchema schema{
+		{"t", {Data::ValueType::integer, Data::Size::b32}},
+		{"x", {Data::ValueType::decimal, Data::Size::b64}},
+		{"n", {Data::ValueType::string}}
+	};
+	if (layout == Data::Table::Layout::columnar) {
+		schema.columns().pop_back();
+		schema.update();
+	}
+	Data::Table table{schema};
+	table.set_layout(layout);
+	Data::ValueRef values[1];
+	values[0] = {static_cast<std::uint32_t>(~0u)};
+	table.push_back(1, values);
+
+	unsigned const count = 0x1000;
+	unsigned const num_fields = 2;
+	aux::vector<Data::ValueRef> fields(count * num_fields);
+	for (unsigned index = 0; index < count; ++index) {
+		fields[index * num_fields + 0] = {static_cast<std::uint32_t>(index)};
+		fields[index * num_fields + 1] = {static_cast<double>(index)};
+	}
+	table.append_batch(count, num_fields, fields.data());
+	table.append_batch(count, [](unsigned const index, Data::ValueRef* const fields) -> unsigned {
+		fields[0] = {static_cast<std::uint32_t>(index + count)};
+		return 1;
+	});
+	DUCT_ASSERTE(table.num_records() == 1 + 2 * count);
+	DUCT_ASSERTE(value_equal(table, 0, 0, {static_cast<std::uint32_t>(~0u)}));
+	for (unsigned index = 0; index < 2 * count; index += 17) {
+		DUCT_ASSERTE(value_equal(table, 1 + index, 0, {static_cast<std::uint32_t>(index)}));
+		DUCT_ASSERTE(value_equal(
+			table, 1 + index, 1,
+			{static_cast<double>(index < count ? index : 0)}
+		));
+	}
+	auto it = table.iterator_at(2 * count);
+	it.set_field(0, {static_cast<std::uint32_t>(7)});
+	if (layout != Data::Table::Layout::columnar) {
+		it.set_field(2, {"string"});
+		DUCT_ASSERTE(value_equal(table, 2 * count, 2, {"string"}));
+	}
+	DUCT_ASSERTE(value_equal(table, 2 * count, 0, {static_cast<std::uint32_t>(7)}));
+	DUCT_ASSERTE(table.aggregate(0).count == 1 + 2 * count);
+	if (layout == Data::Table::Layout::columnar) {
+		return;
+	}
+
+	// Produced string data only lives until the next call
+	char name[16];
+	table.append_batch(count, [&name](unsigned const index, Data::ValueRef* const fields) -> unsigned {
+		fields[0] = {static_cast<std::uint32_t>(index)};
+		fields[1] = {static_cast<double>(index)};
+		unsigned const size = std::snprintf(name, sizeof(name), "name%u", index);
+		fields[2] = {name, size};
+		return 3;
+	});
+	DUCT_ASSERTE(table.num_records() == 1 + 3 * count);
+	for (unsigned index = 0; index < count; index += 17) {
+		unsigned const size = std::snprintf(name, sizeof(name), "name%u", index);
+		DUCT_ASSERTE(value_equal(table, 1 + 2 * count + index, 2, {name, size}));
+	}
+}
+
+struct CountingAllocator final
+	: public Data::ChunkAllocator
+{
+	Data::ChunkPool pool{};
+	unsigned num_live{0};
+	unsigned last_size{0};
+
+	std::uint8_t*
+	allocate_impl(
+		unsigned& size
+	) override {
+		++num_live;
+		last_size = size;
+		return pool.allocate(size);
+	}
+
+	void
+	free_impl(
+		std::uint8_t* const data,
+		unsigned const size
+	) noexcept override {
+		--num_live;
+		pool.free(data, size);
+	}
+};
+
+void
+test_allocator() {
+	CountingAllocator allocator{};
+	{
+		Data::TableSchema schema{
+			{"t", {Data::ValueType::integer, Data::Size::b32}},
+			{"n", {Data::ValueType::string}}
+		};
+		Data::Table table{};
+		table.set_allocator(&allocator);
+		table.configure(schema);
+		Data::ValueRef values[2];
+		for (unsigned index = 0; index < 0x1000; ++index) {
+			values[0] = {static_cast<std::uint32_t>(index)};
+			values[1] = {"value"};
+			table.push_back(2, values);
+		}
+		DUCT_ASSERTE(0 < allocator.num_live);
+		table.optimize_storage();
+		DUCT_ASSERTE(0 < allocator.pool.num_retained());
+
+		Data::Table copy{};
+		copy.set_allocator(&allocator);
+		copy.assign(table);
+		table.clear();
+		DUCT_ASSERTE(value_equal(copy, 0, 0, {static_cast<std::uint32_t>(0)}));
+		DUCT_ASSERTE(value_equal(copy, 0xFFF, 1, {"value"}));
+
+		// The last chunk of a batch fits the rest of the batch
+		unsigned const count = 0x10;
+		aux::vector<Data::ValueRef> fields(2 * count);
+		for (unsigned index = 0; index < count; ++index) {
+			fields[2 * index + 0] = {static_cast<std::uint32_t>(index)};
+			fields[2 * index + 1] = {"value"};
+		}
+		Data::Table batch{};
+		batch.set_allocator(&allocator);
+		batch.configure(schema);
+		allocator.last_size = 0;
+		batch.append_batch(count, 2, fields.data());
+		DUCT_ASSERTE(0 < allocator.last_size && allocator.last_size < 0x400);
+		DUCT_ASSERTE(value_equal(batch, count - 1, 1, {"value"}));
+	}
+	DUCT_ASSERTE(allocator.num_live == 0);
+	allocator.pool.release();
+	DUCT_ASSERTE(allocator.pool.num_retained() == 0);
+}
+
+void
+test_compact(
+	Data::Table::Layout const layout
+) {
+	Data::TableSchema schema{
+		{"t", {Data::ValueType::integer, Data::Size::b32}},
+		{"n", {Data::ValueType::string, Data::Size::b16}}
+	};
+	Data::Table table{schema};
+	table.set_layout(layout);
+	String const str(0x80, 'V');
+	Data::ValueRef values[2];
+	unsigned const count = 0x400;
+	for (unsigned index = 0; index < count; ++index) {
+		values[0] = {static_cast<std::uint32_t>(index)};
+		values[1] = {str};
+		table.push_back(2, values);
+	}
+	table.optimize_storage();
+	std::stringstream full_stream{};
+	{
+		auto ser = make_output_serializer(full_stream);
+		ser(table);
+	}
+
+	// Shrinking fields leaves slack in their records
+	auto it = table.begin();
+	for (unsigned index = 0; index < count; index += 2, it += 2) {
+		it.set_field(1, {"v"});
+	}
+	table.compact_storage();
+	std::stringstream compact_stream{};
+	{
+		auto ser = make_output_serializer(compact_stream);
+		ser(table);
+	}
+	DUCT_ASSERTE(compact_stream.str().size() < full_stream.str().size() * 3 / 4);
+	DUCT_ASSERTE(value_equal(table, 0, 1, {"v"}));
+	DUCT_ASSERTE(value_equal(table, 1, 1, {str}));
+	DUCT_ASSERTE(value_equal(table, count - 1, 0, {static_cast<std::uint32_t>(count - 1)}));
+
+	Data::Table copy{};
+	round_trip(table, copy);
+	DUCT_ASSERTE(copy.num_records() == count);
+	DUCT_ASSERTE(value_equal(copy, count - 2, 1, {"v"}));
+	DUCT_ASSERTE(value_equal(copy, count - 1, 1, {str}));
+}
+
+void
+test_chunk_tree(
+	Data::Table::Layout const layout
+) {
+	Data::TableSchema schema{
+		{"t", {Data::ValueType::integer, Data::Size::b32}},
+		{"n", {Data::ValueType::string, Data::Size::b16}}
+	};
+	Data::Table table{schema};
+	table.set_layout(layout);
+	String const str(0x100, 'V');
+	Data::ValueRef values[2];
+	aux::vector<std::uint32_t> expected;
+
+	// Scattered inserts split chunks throughout the table
+	unsigned position = 0;
+	for (unsigned value = 0; value < 0x800; ++value) {
+		position = (position * 7 + 13) % (expected.size() + 1);
+		values[0] = {value};
+		values[1] = {str};
+		auto it = table.iterator_at(position);
+		it.insert(2, values);
+		expected.insert(expected.begin() + position, value);
+	}
+	DUCT_ASSERTE(table.num_records() == expected.size());
+	unsigned index = 0;
+	for (auto it = table.begin(); it != table.end(); ++it, ++index) {
+		DUCT_ASSERTE(it.get_field(0).data.u32 == expected[index]);
+	}
+	for (index = 0; index < expected.size(); index += 0x61) {
+		DUCT_ASSERTE(value_equal(table, index, 0, {expected[index]}));
+	}
+
+	// Removal through a held iterator erases chunks under its hint
+	position = expected.size() / 3;
+	auto held = table.iterator_at(position);
+	for (index = 0; index < 0x100; ++index) {
+		DUCT_ASSERTE(held.get_field(0).data.u32 == expected[position]);
+		held.remove();
+		expected.erase(expected.begin() + position);
+	}
+	DUCT_ASSERTE(held.get_field(0).data.u32 == expected[position]);
+
+	// Random seeks followed by sequential reads
+	for (index = 0; index < expected.size(); index += 0x65) {
+		auto it = table.iterator_at(index);
+		unsigned const end = min_ce(index + 0x80, static_cast<unsigned>(expected.size()));
+		for (unsigned inner = index; inner < end; ++inner, ++it) {
+			DUCT_ASSERTE(it.get_field(0).data.u32 == expected[inner]);
+			DUCT_ASSERTE(it.get_field(1).size == str.size());
+		}
+	}
+
+	// Removal drains whole chunks from the tree
+	while (expected.size() > 0x10) {
+		position = (position * 5 + 3) % expected.size();
+		auto it = table.iterator_at(position);
+		it.remove();
+		expected.erase(expected.begin() + position);
+	}
+	auto it = table.begin();
+	for (index = 0; index < expected.size(); ++index, ++it) {
+		DUCT_ASSERTE(value_equal(table, index, 0, {expected[index]}));
+		DUCT_ASSERTE(it.get_field(0).data.u32 == expected[index]);
+	}
+	DUCT_ASSERTE(it == table.end());
+	table.optimize_storage();
+	DUCT_ASSERTE(value_equal(table, 0, 0, {expected.front()}));
+	DUCT_ASSERTE(value_equal(table, expected.size() - 1, 0, {expected.back()}));
+}
+
+void
+test_share(
+	Data::Table::Layout const layout
+) {
+	bool const columnar = layout == Data::Table::Layout::columnar;
+	Data::TableSchema schema{
+		{"t", {Data::ValueType::integer, Data::Size::b32}},
+		columnar
+		? Data::TableSchema::Column{"n", {Data::ValueType::integer, Data::Size::b16}}
+		: Data::TableSchema::Column{"n", {Data::ValueType::string, Data::Size::b16}}
+	};
+	CountingAllocator allocator{};
+	{
+		Data::Table table{};
+		table.set_allocator(&allocator);
+		table.configure(schema);
+		table.set_layout(layout);
+		Data::ValueRef values[2];
+		unsigned const count = 0x800;
+		for (unsigned index = 0; index < count; ++index) {
+			values[0] = {static_cast<std::uint32_t>(index)};
+			values[1] = columnar ? Data::ValueRef{static_cast<std::uint16_t>(index)} : Data::ValueRef{"value"};
+			table.push_back(2, values);
+		}
+		unsigned const num_chunks = allocator.num_live;
+
+		// Concurrent copies of a const table count every owner
+		{
+			Data::Table const& source = table;
+			Data::Table copies[4];
+			std::thread threads[4];
+			for (unsigned index = 0; index < 4; ++index) {
+				threads[index] = std::thread([&source, &copies, index]() {
+					copies[index].assign(source);
+				});
+			}
+			for (auto& thread : threads) {
+				thread.join();
+			}
+			DUCT_ASSERTE(allocator.num_live == num_chunks);
+			auto it = copies[0].iterator_at(0);
+			it.set_field(0, {static_cast<std::uint32_t>(0xFFFF)});
+			DUCT_ASSERTE(allocator.num_live == num_chunks + 1);
+			for (unsigned index = 1; index < 4; ++index) {
+				DUCT_ASSERTE(value_equal(copies[index], 0, 0, {static_cast<std::uint32_t>(0)}));
+			}
+		}
+		DUCT_ASSERTE(allocator.num_live == num_chunks);
+
+		// Copies share every chunk
+		Data::Table copy_a{};
+		Data::Table copy_b{};
+		copy_a.assign(table);
+		copy_b.assign(copy_a);
+		DUCT_ASSERTE(allocator.num_live == num_chunks);
+
+		// Modification copies only the modified chunk
+		auto it = copy_a.iterator_at(5);
+		it.set_field(0, {static_cast<std::uint32_t>(0xFFFF)});
+		DUCT_ASSERTE(allocator.num_live == num_chunks + 1);
+		it = table.iterator_at(count - 1);
+		it.remove();
+		DUCT_ASSERTE(allocator.num_live == num_chunks + 2);
+		DUCT_ASSERTE(value_equal(copy_a, 5, 0, {static_cast<std::uint32_t>(0xFFFF)}));
+		DUCT_ASSERTE(value_equal(table, 5, 0, {static_cast<std::uint32_t>(5)}));
+		DUCT_ASSERTE(value_equal(copy_b, 5, 0, {static_cast<std::uint32_t>(5)}));
+		DUCT_ASSERTE(table.num_records() == count - 1);
+		DUCT_ASSERTE(copy_b.num_records() == count);
+
+		// Shared data outlives the table it was assigned from
+		table = Data::Table{};
+		copy_a.push_back(2, values);
+		copy_a.optimize_storage();
+		DUCT_ASSERTE(copy_a.num_records() == count + 1);
+		DUCT_ASSERTE(value_equal(copy_b, count - 1, 0, {static_cast<std::uint32_t>(count - 1)}));
+		DUCT_ASSERTE(value_equal(copy_a, count, 0, {static_cast<std::uint32_t>(count - 1)}));
+		copy_a.clear();
+		copy_b.compact_storage();
+		DUCT_ASSERTE(value_equal(copy_b, 0, 0, {static_cast<std::uint32_t>(0)}));
+	}
+	DUCT_ASSERTE(allocator.num_live == 0);
+}
+
+void
+test_migrate(
+	Data::Table::Layout const layout
+) {
+	Data::TableSchema schema{
+		{"t", {Data::ValueType::integer, Data::Size::b32}},
+		{"n", {Data::ValueType::string, Data::Size::b16}}
+	};
+	Data::Table table{schema};
+	table.set_layout(layout);
+	String const str(0x40, 'V');
+	Data::ValueRef values[2];
+	unsigned const count = 0x8000;
+	for (unsigned index = 0; index < count; ++index) {
+		values[0] = {static_cast<std::uint32_t>(index)};
+		values[1] = {str};
+		table.push_back(2, values);
+	}
+
+	// Widen the integer column and insert a column in front of it
+	auto& columns = schema.columns();
+	columns[0].index = 0;
+	columns[0].type = {Data::ValueType::integer, Data::Size::b64};
+	columns[1].index = 1;
+	columns.insert(columns.begin(), {"f", {Data::ValueType::decimal, Data::Size::b32}});
+	schema.update();
+	DUCT_ASSERTE(table.configure(schema));
+	DUCT_ASSERTE(table.num_records() == count);
+	auto it = table.begin();
+	for (unsigned index = 0; index < count; ++index, ++it) {
+		DUCT_ASSERTE(it.get_field(1).data.u64 == index);
+	}
+	DUCT_ASSERTE(value_equal(table, 0, 0, {0.0f}));
+	DUCT_ASSERTE(value_equal(table, count - 1, 2, {str}));
+	it = table.iterator_at(count / 2);
+	it.set_field(2, {"v"});
+	DUCT_ASSERTE(value_equal(table, count / 2, 2, {"v"}));
+}
+
+void
+test_instant_columns(
+	Data::Table::Layout const layout
+) {
+	bool const columnar = layout == Data::Table::Layout::columnar;
+	Data::TableSchema schema{
+		{"t", {Data::ValueType::integer, Data::Size::b32}},
+		columnar
+		? Data::TableSchema::Column{"n", {Data::ValueType::integer, Data::Size::b16}}
+		: Data::TableSchema::Column{"n", {Data::ValueType::string, Data::Size::b16}}
+	};
+	CountingAllocator allocator{};
+	{
+	Data::Table table{};
+	table.set_allocator(&allocator);
+	table.configure(schema);
+	table.set_layout(layout);
+	Data::ValueRef values[3];
+	unsigned const count = 0x800;
+	for (unsigned index = 0; index < count; ++index) {
+		values[0] = {static_cast<std::uint32_t>(index)};
+		values[1] = columnar ? Data::ValueRef{static_cast<std::uint16_t>(index)} : Data::ValueRef{"value"};
+		table.push_back(2, values);
+	}
+	table.set_index_column(1);
+	table.set_ordered_index_column(0);
+	unsigned const num_chunks = allocator.num_live;
+
+	// Drop a column and append another without rewriting records
+	auto& columns = schema.columns();
+	columns[0].index = 0;
+	columns[1] = {"x", {Data::ValueType::integer, Data::Size::b8}};
+	schema.update();
+	DUCT_ASSERTE(table.configure(schema));
+	DUCT_ASSERTE(allocator.num_live == num_chunks);
+	DUCT_ASSERTE(table.num_columns() == 2);
+	DUCT_ASSERTE(value_equal(table, count - 1, 0, {static_cast<std::uint32_t>(count - 1)}));
+	DUCT_ASSERTE(value_equal(table, count - 1, 1, {static_cast<std::uint8_t>(0)}));
+	DUCT_ASSERTE(table.aggregate(0).sum == count * (count - 1) / 2);
+	DUCT_ASSERTE(table.index_column() == ~0u);
+	DUCT_ASSERTE(table.ordered_index_column() == 0);
+
+	using Compare = Data::Table::Compare;
+	Data::Table::Filter filter{};
+	aux::vector<unsigned> indices{};
+	filter.terms.push_back({1, Compare::equal, {static_cast<std::int64_t>(0)}});
+	DUCT_ASSERTE(table.select(filter, indices) == count);
+
+	// Modified chunks are upgraded
+	values[0] = {static_cast<std::uint32_t>(0xFFFF)};
+	values[1] = {static_cast<std::uint8_t>(7)};
+	auto it = table.iterator_at(count / 2);
+	it.insert(2, values);
+	it = table.iterator_at(count / 4);
+	it.set_field(1, {static_cast<std::uint8_t>(9)});
+	DUCT_ASSERTE(value_equal(table, count / 2, 0, {static_cast<std::uint32_t>(0xFFFF)}));
+	DUCT_ASSERTE(value_equal(table, count / 2, 1, {static_cast<std::uint8_t>(7)}));
+	DUCT_ASSERTE(value_equal(table, count / 2 + 1, 0, {static_cast<std::uint32_t>(count / 2)}));
+	DUCT_ASSERTE(value_equal(table, count / 4, 1, {static_cast<std::uint8_t>(9)}));
+	DUCT_ASSERTE(table.select(filter, indices) == count - 1);
+	DUCT_ASSERTE(table.select_range(0, {std::uint64_t{0xFFFF}}, {std::uint64_t{0xFFFF}}, indices) == 1);
+	DUCT_ASSERTE(indices[0] == count / 2);
+
+	// Versions compose
+	columns[1].index = 1;
+	columns.push_back({"s", {Data::ValueType::string, Data::Size::b8}});
+	schema.update();
+	DUCT_ASSERTE(table.configure(schema));
+	DUCT_ASSERTE(value_equal(table, 0, 2, {""}));
+	DUCT_ASSERTE(value_equal(table, count / 2, 1, {static_cast<std::uint8_t>(7)}));
+	DUCT_ASSERTE(value_equal(table, count, 0, {static_cast<std::uint32_t>(count - 1)}));
+	it = table.iterator_at(count);
+	it.remove();
+	DUCT_ASSERTE(table.num_records() == count);
+	DUCT_ASSERTE(table.ordered_index_column() == 0);
+	DUCT_ASSERTE(table.select_range(0, {std::uint64_t{count - 2}}, {std::uint64_t{0xFFFF}}, indices) == 2);
+	DUCT_ASSERTE(indices[0] == count / 2 && indices[1] == count - 1);
+
+	Data::Table copy{};
+	round_trip(table, copy);
+	DUCT_ASSERTE(copy.num_records() == count);
+	DUCT_ASSERTE(value_equal(copy, count / 4, 1, {static_cast<std::uint8_t>(9)}));
+	DUCT_ASSERTE(value_equal(copy, count - 1, 0, {static_cast<std::uint32_t>(count - 2)}));
+	DUCT_ASSERTE(value_equal(copy, count - 1, 2, {""}));
+	DUCT_ASSERTE(value_equal(table, count / 2, 1, {static_cast<std::uint8_t>(7)}));
+	}
+	DUCT_ASSERTE(allocator.num_live == 0);
+}
+
+void
+test_index(
+	Data::Table::Layout const layout
+) {
+	bool const columnar = layout == Data::Table::Layout::columnar;
+	Data::TableSchema schema{
+		{"t", {Data::ValueType::integer, Data::Size::b32}},
+		columnar
+		? Data::TableSchema::Column{"n", {Data::ValueType::integer, Data::Size::b16}}
+		: Data::TableSchema::Column{"n", {Data::ValueType::string, Data::Size::b16}}
+	};
+	auto const key = [columnar](unsigned const index) -> Data::ValueRef {
+		static char s_buffer[8];
+		if (columnar) {
+			return {static_cast<std::uint16_t>(index)};
+		}
+		signed const size = std::snprintf(s_buffer, sizeof(s_buffer), "k%u", index);
+		return {s_buffer, static_cast<unsigned>(size)};
+	};
+	Data::Table table{schema};
+	table.set_layout(layout);
+	Data::ValueRef values[2];
+	unsigned const count = 0x400;
+	for (unsigned index = 0; index < count; ++index) {
+		values[0] = {static_cast<std::uint32_t>(index)};
+		values[1] = key(index);
+		table.push_back(2, values);
+	}
+	DUCT_ASSERTE(table.index_column() == ~0u);
+	DUCT_ASSERTE(table.find(1, key(count / 3)).index == count / 3);
+	table.set_index_column(1);
+	DUCT_ASSERTE(table.index_column() == 1);
+	DUCT_ASSERTE(table.find(1, key(count / 3)).index == count / 3);
+	DUCT_ASSERTE(!table.find(1, key(count + 1)).can_advance());
+	DUCT_ASSERTE(!table.find(2, key(0)).can_advance());
+
+	// Positions follow insertions and removals
+	values[0] = {static_cast<std::uint32_t>(~0u)};
+	values[1] = key(count + 1);
+	auto it = table.iterator_at(count / 2);
+	it.insert(2, values);
+	DUCT_ASSERTE(table.find(1, key(count + 1)).index == count / 2);
+	DUCT_ASSERTE(table.find(1, key(count / 2)).index == count / 2 + 1);
+	DUCT_ASSERTE(table.find(1, key(count / 3)).index == count / 3);
+	it = table.iterator_at(0);
+	it.remove();
+	DUCT_ASSERTE(!table.find(1, key(0)).can_advance());
+	DUCT_ASSERTE(table.find(1, key(count + 1)).index == count / 2 - 1);
+	DUCT_ASSERTE(table.find(1, key(count - 1)).index == count - 1);
+
+	// Duplicates resolve to the first record
+	it = table.iterator_at(4);
+	it.set_field(1, key(count + 1));
+	DUCT_ASSERTE(table.find(1, key(count + 1)).index == 4);
+	DUCT_ASSERTE(!table.find(1, key(5)).can_advance());
+	table.append_batch(1, [&key](unsigned const, Data::ValueRef* const fields) -> unsigned {
+		fields[0] = {static_cast<std::uint32_t>(0)};
+		fields[1] = key(0);
+		return 2;
+	});
+	DUCT_ASSERTE(table.find(1, key(0)).index == count);
+
+	Data::Table copy{};
+	round_trip(table, copy);
+	copy.set_index_column(1);
+	DUCT_ASSERTE(copy.find(1, key(count / 2)).index == count / 2);
+	DUCT_ASSERTE(copy.find(1, key(0)).index == count);
+
+	// Interleaved middle insertions and removals
+	for (unsigned index = 0; index < 0x40; ++index) {
+		values[0] = {static_cast<std::uint32_t>(index)};
+		values[1] = key(count + 2 + index);
+		it = copy.iterator_at((index * 37) % copy.num_records());
+		it.insert(2, values);
+		if (index & 1) {
+			it = copy.iterator_at((index * 11) % copy.num_records());
+			it.remove();
+		}
+	}
+	for (it = copy.begin(); it.can_advance(); ++it) {
+		auto const found = copy.find(1, copy.get_field(it, 1));
+		DUCT_ASSERTE(found.index <= it.index);
+		DUCT_ASSERTE(copy.get_field(found, 1) == copy.get_field(it, 1));
+	}
+
+	// The index follows its column
+	auto& columns = schema.columns();
+	std::swap(columns[0], columns[1]);
+	columns[0].index = 1;
+	columns[1].index = 0;
+	schema.update();
+	table.configure(schema);
+	DUCT_ASSERTE(table.index_column() == 0);
+	DUCT_ASSERTE(table.find(0, key(count / 2)).index == count / 2);
+	columns.erase(columns.begin());
+	columns[0].index = 1;
+	schema.update();
+	table.configure(schema);
+	DUCT_ASSERTE(table.index_column() == ~0u);
+}
+
+void
+test_ordered_index(
+	Data::Table::Layout const layout
+) {
+	Data::TableSchema schema{
+		{"t", {Data::ValueType::integer, Data::ValueFlag::integer_signed, Data::Size::b32}},
+		{"x", {Data::ValueType::decimal, Data::Size::b64}}
+	};
+	Data::Table table{schema};
+	table.set_layout(layout);
+	Data::ValueRef values[2];
+	signed const count = 0x400;
+	for (signed index = 0; index < count; ++index) {
+		values[0] = {static_cast<std::int32_t>(index - count / 2)};
+		values[1] = {static_cast<double>(count - index) - 0.5};
+		table.push_back(2, values);
+	}
+	aux::vector<unsigned> linear{};
+	aux::vector<unsigned> indices{};
+	DUCT_ASSERTE(table.select_range(0, {std::int64_t{-4}}, {std::int64_t{3}}, linear) == 8);
+	table.set_ordered_index_column(0);
+	DUCT_ASSERTE(table.ordered_index_column() == 0);
+	DUCT_ASSERTE(table.select_range(0, {std::int64_t{-4}}, {std::int64_t{3}}, indices) == 8);
+	DUCT_ASSERTE(indices == linear);
+	DUCT_ASSERTE(indices.front() == count / 2 - 4);
+	DUCT_ASSERTE(table.select_range(0, {std::int64_t{3}}, {std::int64_t{-4}}, indices) == 0);
+
+	// Decimals are ordered across signs
+	table.set_ordered_index_column(1);
+	DUCT_ASSERTE(table.select_range(1, {-2.0}, {0.0}, linear) == 0);
+	DUCT_ASSERTE(table.select_range(1, {0.0}, {2.0}, indices) == 2);
+	DUCT_ASSERTE(indices[0] == count - 2 && indices[1] == count - 1);
+	auto it = table.iterator_at(count - 1);
+	it.set_field(1, {-1.5});
+	DUCT_ASSERTE(table.select_range(1, {-2.0}, {2.0}, indices) == 2);
+	DUCT_ASSERTE(table.select_range(1, {-2.0}, {0.0}, indices) == 1);
+	DUCT_ASSERTE(indices[0] == count - 1);
+
+	// Positions follow insertions and removals
+	table.set_ordered_index_column(0);
+	values[0] = {static_cast<std::int32_t>(0)};
+	it = table.iterator_at(0);
+	it.insert(2, values);
+	DUCT_ASSERTE(table.select_range(0, {std::int64_t{0}}, {std::int64_t{0}}, indices) == 2);
+	DUCT_ASSERTE(indices[0] == 0 && indices[1] == count / 2 + 1);
+	it = table.iterator_at(1);
+	it.remove();
+	DUCT_ASSERTE(table.select_range(0, {std::int64_t{-count}}, {std::int64_t{count}}, indices) == count);
+	DUCT_ASSERTE(indices.back() == count - 1);
+	DUCT_ASSERTE(table.select_range(0, {std::int64_t{1 - count / 2}}, {std::int64_t{1 - count / 2}}, indices) == 1);
+	DUCT_ASSERTE(indices[0] == 1);
+
+	// Positions follow batch removals, sorts, and sorted insertions
+	table.remove_if([](Data::Table::Iterator const& it) -> bool {
+		return it.index % 3 == 0;
+	});
+	table.sort_by({1}, Data::Table::Order::descending);
+	for (signed index = 0; index < 0x10; ++index) {
+		values[0] = {static_cast<std::int32_t>(index * 0x11 - count / 2)};
+		values[1] = {static_cast<double>(index)};
+		table.insert_sorted({1}, Data::Table::Order::descending, 2, values);
+	}
+	for (signed lower = -count / 2; lower < count / 2; lower += 0x30) {
+		table.select_range(0, {std::int64_t{lower}}, {std::int64_t{lower + 0x20}}, indices);
+		linear.clear();
+		for (it = table.begin(); it.can_advance(); ++it) {
+			signed const value = it.get_field(0).data.s32;
+			if (lower <= value && value <= lower + 0x20) {
+				linear.push_back(it.index);
+			}
+		}
+		DUCT_ASSERTE(indices == linear);
+	}
+
+	// Only numeric columns can be ordered-indexed
+	auto& columns = schema.columns();
+	columns[0].index = 0;
+	columns[1].index = 1;
+	columns.push_back({"n", {Data::ValueType::string}});
+	schema.update();
+	table.configure(schema);
+	DUCT_ASSERTE(table.ordered_index_column() == 0);
+	table.set_ordered_index_column(2);
+	DUCT_ASSERTE(table.ordered_index_column() == ~0u);
+	DUCT_ASSERTE(table.select_range(2, {""}, {"z"}, indices) == 0);
+}
+
+void
+test_dictionary(
+	Data::Table::Layout const layout
+) {
+	Data::TableSchema schema{
+		{"t", {Data::ValueType::integer, Data::Size::b32}},
+		{"host", {Data::ValueType::string, Data::ValueFlag::string_dictionary, Data::Size::b8}}
+	};
+	char const* const hosts[]{"", "alpha", "beta", "gamma"};
+	Data::Table table{schema};
+	table.set_layout(layout);
+	DUCT_ASSERTE(table.layout() == layout);
+	Data::ValueRef values[2];
+	unsigned const count = 0x400;
+	for (unsigned index = 0; index < count; ++index) {
+		values[0] = {static_cast<std::uint32_t>(index)};
+		values[1] = {hosts[index % 4], static_cast<unsigned>(std::strlen(hosts[index % 4]))};
+		table.push_back(2, values);
+	}
+	// NB: Fields are not replaced by codes
+	DUCT_ASSERTE(values[1].type == Data::ValueType::string);
+	DUCT_ASSERTE(value_equal(table, 0, 1, {""}));
+	DUCT_ASSERTE(value_equal(table, 5, 1, {"alpha"}));
+	DUCT_ASSERTE(value_equal(table, count - 1, 1, {"gamma"}));
+
+	using Compare = Data::Table::Compare;
+	Data::Table::Filter filter{};
+	aux::vector<unsigned> indices{};
+	filter.terms.push_back({1, Compare::equal, {"beta"}});
+	DUCT_ASSERTE(table.select(filter, indices) == count / 4);
+	DUCT_ASSERTE(indices[0] == 2);
+	filter.terms[0] = {1, Compare::not_equal, {"beta"}};
+	DUCT_ASSERTE(table.select(filter, indices) == 3 * count / 4);
+	filter.terms[0] = {1, Compare::equal, {"delta"}};
+	DUCT_ASSERTE(table.select(filter, indices) == 0);
+	filter.terms[0] = {1, Compare::not_equal, {"delta"}};
+	DUCT_ASSERTE(table.select(filter, indices) == count);
+	filter.terms[0] = {1, Compare::less, {"beta"}};
+	DUCT_ASSERTE(table.select(filter, indices) == count / 2);
+
+	// Modified values join the dictionary
+	table.set_index_column(1);
+	auto it = table.iterator_at(1);
+	it.set_field(1, {"delta"});
+	DUCT_ASSERTE(value_equal(table, 1, 1, {"delta"}));
+	DUCT_ASSERTE(table.find(1, {"delta"}).index == 1);
+	DUCT_ASSERTE(table.find(1, {"alpha"}).index == 5);
+	filter.terms[0] = {1, Compare::equal, {"delta"}};
+	DUCT_ASSERTE(table.select(filter, indices) == 1);
+
+	Data::Table copy{};
+	round_trip(table, copy);
+	DUCT_ASSERTE(copy.layout() == layout);
+	DUCT_ASSERTE(value_equal(copy, 1, 1, {"delta"}));
+	DUCT_ASSERTE(value_equal(copy, count - 1, 1, {"gamma"}));
+	DUCT_ASSERTE(copy.select(filter, indices) == 1);
+	values[1] = {"epsilon"};
+	copy.push_back(2, values);
+	DUCT_ASSERTE(value_equal(copy, count, 1, {"epsilon"}));
+
+	// Codes are exhausted after 255 distinct non-empty values
+	char buffer[8];
+	for (unsigned index = 5; index < 0x100; ++index) {
+		signed const size = std::snprintf(buffer, sizeof(buffer), "h%u", index);
+		values[1] = {buffer, static_cast<unsigned>(size)};
+		table.push_back(2, values);
+	}
+	values[1] = {"full"};
+	try {
+		table.push_back(2, values);
+		DUCT_ASSERTE(false);
+	} catch (Hord::Error const& err) {
+		DUCT_ASSERTE(err.code() == ErrorCode::table_dictionary_full);
+	}
+	DUCT_ASSERTE(table.num_records() == count + 0xFB);
+	values[1] = {"gamma"};
+	table.push_back(2, values);
+
+	// Coding can be changed
+	auto& columns = schema.columns();
+	columns[0].index = 0;
+	columns[1].index = 1;
+	columns[1].type = {Data::ValueType::string, Data::Size::b8};
+	schema.update();
+	DUCT_ASSERTE(table.configure(schema));
+	DUCT_ASSERTE(value_equal(table, 1, 1, {"delta"}));
+	DUCT_ASSERTE(value_equal(table, count + 1, 1, {"h6"}));
+	DUCT_ASSERTE(table.find(1, {"delta"}).index == 1);
+	columns[1].type = {Data::ValueType::string, Data::ValueFlag::string_dictionary, Data::Size::b16};
+	schema.update();
+	DUCT_ASSERTE(table.configure(schema));
+	DUCT_ASSERTE(value_equal(table, 2, 1, {"beta"}));
+	DUCT_ASSERTE(value_equal(table, count + 0xFB, 1, {"gamma"}));
+	filter.terms[0] = {1, Compare::equal, {"gamma"}};
+	DUCT_ASSERTE(table.select(filter, indices) == count / 4 + 1);
+	table.clear();
+	DUCT_ASSERTE(table.empty());
+	table.push_back(1, values);
+	DUCT_ASSERTE(value_equal(table, 0, 1, {""}));
+}
+
+void
+test_codecs(
+	Data::Table::Layout const layout
+) {
+	Data::TableSchema const schema{
+		{"id", {Data::ValueType::integer, Data::Size::b32}},
+		{"offset", {Data::ValueType::integer, Data::ValueFlag::integer_signed, Data::Size::b16}},
+		{"state", {Data::ValueType::integer, Data::Size::b8}},
+		{"noise", {Data::ValueType::integer, Data::ValueFlag::integer_signed, Data::Size::b64}},
+		{"ratio", {Data::ValueType::decimal, Data::Size::b64}},
+		{"host", {Data::ValueType::string, Data::ValueFlag::string_dictionary, Data::Size::b8}}
+	};
+	Data::Table table{schema};
+	table.set_layout(layout);
+	DUCT_ASSERTE(table.layout() == layout);
+
+	// Sequential, narrow-ranged, repetitive, and full-range values
+	unsigned const count = 0x1000;
+	std::uint64_t state = 0x9E3779B97F4A7C15u;
+	Data::ValueRef values[6];
+	for (unsigned index = 0; index < count; ++index) {
+		state = state * 6364136223846793005u + 1442695040888963407u;
+		values[0] = {static_cast<std::uint32_t>(1000 + index)};
+		values[1] = {static_cast<std::int16_t>(static_cast<signed>(index % 50) - 25)};
+		values[2] = {static_cast<std::uint8_t>(index / 0x300)};
+		values[3] = {
+			index % 3 == 0 ? INT64_MIN
+			: index % 3 == 1 ? INT64_MAX
+			: static_cast<std::int64_t>(state)
+		};
+		values[4] = {0.5};
+		if (index < 0x10) {
+			values[5] = {"alpha"};
+		} else {
+			values[5] = {"beta"};
+		}
+		table.push_back(6, values);
+	}
+
+	std::stringstream stream;
+	auto ser_out = make_output_serializer(stream);
+	ser_out(table);
+	auto const size = static_cast<unsigned>(stream.str().size());
+	Data::Table copy{};
+	auto ser_in = make_input_serializer(stream);
+	ser_in(copy);
+	DUCT_ASSERTE(copy.layout() == layout);
+	DUCT_ASSERTE(copy.num_records() == count);
+	auto it = table.begin();
+	auto copy_it = copy.begin();
+	for (; it != table.end(); ++it, ++copy_it) {
+		for (unsigned column = 0; column < 6; ++column) {
+			DUCT_ASSERTE(it.get_field(column) == copy_it.get_field(column));
+		}
+	}
+	DUCT_ASSERTE(value_equal(copy, 3, 3, {INT64_MIN}));
+	DUCT_ASSERTE(value_equal(copy, 4, 3, {INT64_MAX}));
+	DUCT_ASSERTE(value_equal(copy, 1, 1, {static_cast<std::int16_t>(-24)}));
+	DUCT_ASSERTE(value_equal(copy, 0x10, 5, {"beta"}));
+
+	// Only the full-range column is written as it is stored
+	DUCT_ASSERTE(size < count * 10);
+
+	// Single records take the least-costly codec too
+	Data::Table single{schema};
+	single.set_layout(layout);
+	single.push_back(6, values);
+	round_trip(single, copy);
+	DUCT_ASSERTE(copy.num_records() == 1);
+	DUCT_ASSERTE(value_equal(copy, 0, 0, {static_cast<std::uint32_t>(1000 + count - 1)}));
+	DUCT_ASSERTE(value_equal(copy, 0, 5, {"beta"}));
+}
+
+void
+test_mapped(
+	Data::Table::Layout const layout
+) {
+	Data::TableSchema schema{
+		{"id", {Data::ValueType::integer, Data::Size::b64}},
+		{"value", {Data::ValueType::decimal, Data::Size::b64}}
+	};
+	bool const has_name = layout != Data::Table::Layout::columnar;
+	if (has_name) {
+		schema.columns().push_back({"name", {Data::ValueType::string, Data::Size::b8}});
+		schema.update();
+	}
+	unsigned const num_columns = has_name ? 3 : 2;
+	Data::Table table{schema};
+	table.set_layout(layout);
+
+	// Full-range values are not worth encoding
+	unsigned const count = 0x800;
+	std::uint64_t state = 0x2545F4914F6CDD1Du;
+	Data::ValueRef values[3];
+	values[2] = {"name"};
+	for (unsigned index = 0; index < count; ++index) {
+		state = state * 6364136223846793005u + 1442695040888963407u;
+		values[0] = {state};
+		values[1] = {static_cast<double>(state >> 11)};
+		table.push_back(num_columns, values);
+	}
+	std::stringstream stream;
+	auto ser_out = make_output_serializer(stream);
+	ser_out(table);
+	String const serialized = stream.str();
+	aux::vector<std::uint8_t> data(serialized.begin(), serialized.end());
+
+	Data::Table mapped{};
+	DUCT_ASSERTE(mapped.read_mapped(data.data(), data.size()) == data.size());
+	DUCT_ASSERTE(mapped.layout() == layout);
+	DUCT_ASSERTE(mapped.num_records() == count);
+	auto it = table.begin();
+	auto mapped_it = mapped.begin();
+	for (; it != table.end(); ++it, ++mapped_it) {
+		for (unsigned column = 0; column < num_columns; ++column) {
+			DUCT_ASSERTE(it.get_field(column) == mapped_it.get_field(column));
+		}
+	}
+
+	// Modifications copy chunks instead of writing to the data
+	Data::Table shared{};
+	shared.assign(mapped);
+	values[0] = {std::uint64_t{7}};
+	mapped_it = mapped.iterator_at(1);
+	mapped_it.set_field(0, values[0]);
+	mapped_it = mapped.iterator_at(count / 2);
+	mapped_it.insert(num_columns, values);
+	mapped_it = mapped.iterator_at(count - 1);
+	mapped_it.remove();
+	DUCT_ASSERTE(std::memcmp(data.data(), serialized.data(), data.size()) == 0);
+	DUCT_ASSERTE(value_equal(mapped, 1, 0, {std::uint64_t{7}}));
+	DUCT_ASSERTE(value_equal(mapped, count / 2, 0, {std::uint64_t{7}}));
+	DUCT_ASSERTE(!value_equal(shared, 1, 0, {std::uint64_t{7}}));
+
+	// Released tables no longer reference the data
+	mapped.release_mapped();
+	shared.release_mapped();
+	std::fill(data.begin(), data.end(), 0xFF);
+	it = table.begin();
+	mapped_it = mapped.begin();
+	for (unsigned index = 0; index < count / 2; ++index, ++it, ++mapped_it) {
+		DUCT_ASSERTE(
+			index == 1 ||
+			it.get_field(0) == mapped_it.get_field(0)
+		);
+	}
+	DUCT_ASSERTE(value_equal(shared, count - 1, 1, table.iterator_at(count - 1).get_field(1)));
+
+	// Chunk data must be within the data
+	data.assign(serialized.begin(), serialized.end() - 1);
+	try {
+		mapped.read_mapped(data.data(), data.size());
+		DUCT_ASSERTE(false);
+	} catch (Hord::Error const& err) {
+		DUCT_ASSERTE(err.code() == ErrorCode::serialization_data_malformed);
+	}
+}
+
+void
+test_sort(
+	Data::Table::Layout const layout
+) {
+	Data::TableSchema const schema{
+		{"group", {Data::ValueType::integer, Data::Size::b8}},
+		{"value", {Data::ValueType::integer, Data::ValueFlag::integer_signed, Data::Size::b32}},
+		{"name", {Data::ValueType::string, Data::ValueFlag::string_dictionary, Data::Size::b8}},
+		{"seq", {Data::ValueType::integer, Data::Size::b32}}
+	};
+	char const* const names[]{"delta", "alpha", "gamma", "beta"};
+	Data::Table table{schema};
+	table.set_layout(layout);
+	table.set_index_column(3);
+
+	unsigned const count = 0x1000;
+	std::uint32_t state = 1;
+	Data::ValueRef values[4];
+	for (unsigned index = 0; index < count; ++index) {
+		state = state * 1103515245u + 12345u;
+		values[0] = {static_cast<std::uint8_t>((state >> 16) % 4)};
+		values[1] = {static_cast<std::int32_t>((state >> 8) % 64) - 32};
+		values[2] = {names[index % 4], static_cast<unsigned>(std::strlen(names[index % 4]))};
+		values[3] = {static_cast<std::uint32_t>(index)};
+		table.push_back(4, values);
+	}
+
+	// Ties keep their order
+	table.sort_by({0, 1});
+	DUCT_ASSERTE(table.num_records() == count);
+	auto it = table.begin();
+	auto prev = it;
+	for (++it; it != table.end(); ++it, ++prev) {
+		auto const group = it.get_field(0).data.u8;
+		auto const prev_group = prev.get_field(0).data.u8;
+		auto const value = it.get_field(1).data.s32;
+		auto const prev_value = prev.get_field(1).data.s32;
+		DUCT_ASSERTE(prev_group <= group);
+		DUCT_ASSERTE(prev_group < group || prev_value <= value);
+		DUCT_ASSERTE(
+			prev_group < group || prev_value < value ||
+			prev.get_field(3).data.u32 < it.get_field(3).data.u32
+		);
+	}
+	it = table.find(3, {static_cast<std::uint32_t>(5)});
+	DUCT_ASSERTE(it != table.end());
+	DUCT_ASSERTE(it.get_field(3).data.u32 == 5);
+
+	// Sorted inserts keep the order
+	values[0] = {static_cast<std::uint8_t>(2)};
+	values[1] = {static_cast<std::int32_t>(0)};
+	values[3] = {static_cast<std::uint32_t>(count)};
+	it = table.insert_sorted({0, 1}, Data::Table::Order::ascending, 4, values);
+	DUCT_ASSERTE(it.get_field(3).data.u32 == count);
+	auto const position = it.index;
+	DUCT_ASSERTE(value_equal(table, position - 1, 0, {static_cast<std::uint8_t>(2)}));
+	DUCT_ASSERTE(table.iterator_at(position - 1).get_field(1).data.s32 <= 0);
+	DUCT_ASSERTE(
+		table.iterator_at(position + 1).get_field(0).data.u8 > 2 ||
+		table.iterator_at(position + 1).get_field(1).data.s32 > 0
+	);
+	values[0] = {static_cast<std::uint8_t>(9)};
+	it = table.insert_sorted({0, 1}, Data::Table::Order::ascending, 1, values);
+	DUCT_ASSERTE(it.index == count + 1);
+	DUCT_ASSERTE(value_equal(table, count + 1, 1, {static_cast<std::int32_t>(0)}));
+
+	// Strings are ordered by value, not by code
+	table.sort_by({2}, Data::Table::Order::descending);
+	DUCT_ASSERTE(value_equal(table, 0, 2, {"gamma"}));
+	DUCT_ASSERTE(value_equal(table, count + 1, 2, {""}));
+	DUCT_ASSERTE(value_equal(table, count, 2, {"alpha"}));
+	values[2] = {"beta"};
+	it = table.insert_sorted({2}, Data::Table::Order::descending, 3, values);
+	DUCT_ASSERTE(value_equal(table, it.index - 1, 2, {"beta"}));
+	DUCT_ASSERTE(value_equal(table, it.index + 1, 2, {"alpha"}));
+	it = table.find(3, {static_cast<std::uint32_t>(count)});
+	DUCT_ASSERTE(value_equal(table, it.index, 0, {static_cast<std::uint8_t>(2)}));
+
+	Data::Table copy{};
+	round_trip(table, copy);
+	DUCT_ASSERTE(value_equal(copy, 0, 2, {"gamma"}));
+
+	try {
+		table.sort_by({4});
+		DUCT_ASSERTE(false);
+	} catch (Hord::Error const& err) {
+		DUCT_ASSERTE(err.code() == ErrorCode::table_column_index_invalid);
+	}
+}
+
+void
+test_remove(
+	Data::Table::Layout const layout
+) {
+	Data::TableSchema schema{
+		{"id", {Data::ValueType::integer, Data::Size::b32}},
+		{"age", {Data::ValueType::integer, Data::Size::b16}}
+	};
+	bool const has_name = layout != Data::Table::Layout::columnar;
+	if (has_name) {
+		schema.columns().push_back({"name", {Data::ValueType::string, Data::Size::b8}});
+		schema.update();
+	}
+	unsigned const num_columns = has_name ? 3 : 2;
+	Data::Table table{schema};
+	table.set_layout(layout);
+	table.set_index_column(0);
+	table.set_ordered_index_column(1);
+
+	unsigned const count = 0x2000;
+	char name[16];
+	Data::ValueRef values[3];
+	for (unsigned index = 0; index < count; ++index) {
+		signed const size = std::snprintf(name, sizeof(name), "record %u", index);
+		values[0] = {static_cast<std::uint32_t>(index)};
+		values[1] = {static_cast<std::uint16_t>(index % 100)};
+		values[2] = {name, static_cast<unsigned>(size)};
+		table.push_back(num_columns, values);
+	}
+	Data::Table shared{};
+	shared.assign(table);
+
+	auto const removed = table.remove_if([](Data::Table::Iterator const& it) {
+		return it.get_field(1).data.u16 % 3 == 0;
+	});
+	DUCT_ASSERTE(removed == 81 * 34 + 31);
+	DUCT_ASSERTE(table.num_records() == count - removed);
+	DUCT_ASSERTE(shared.num_records() == count);
+	std::uint32_t prev = 0;
+	for (auto it = table.begin(); it != table.end(); ++it) {
+		auto const id = it.get_field(0).data.u32;
+		DUCT_ASSERTE(id % 100 % 3 != 0);
+		DUCT_ASSERTE(it.index == 0 || prev < id);
+		if (has_name) {
+			signed const size = std::snprintf(name, sizeof(name), "record %u", id);
+			DUCT_ASSERTE(it.get_field(2) == Data::ValueRef(name, static_cast<unsigned>(size)));
+		}
+		prev = id;
+	}
+	DUCT_ASSERTE(table.find(0, {static_cast<std::uint32_t>(3)}) == table.end());
+	DUCT_ASSERTE(table.find(0, {static_cast<std::uint32_t>(4)}).index == 2);
+	aux::vector<unsigned> indices{};
+	DUCT_ASSERTE(table.select_range(1, {0u}, {5u}, indices) == 4 * (count / 100 + 1));
+	DUCT_ASSERTE(indices[0] == 0 && indices[1] == 1 && indices[2] == 2 && indices[3] == 3);
+
+	// Ranges
+	DUCT_ASSERTE(table.erase(table.iterator_at(10), table.iterator_at(20)) == 10);
+	DUCT_ASSERTE(table.num_records() == count - removed - 10);
+	DUCT_ASSERTE(value_equal(table, 9, 0, {static_cast<std::uint32_t>(14)}));
+	DUCT_ASSERTE(value_equal(table, 10, 0, {static_cast<std::uint32_t>(31)}));
+	DUCT_ASSERTE(table.erase(table.iterator_at(20), table.iterator_at(10)) == 0);
+
+	// Selections
+	using Compare = Data::Table::Compare;
+	Data::Table::Filter filter{};
+	Data::Table::Selection selection{};
+	filter.terms.push_back({1, Compare::greater_equal, {50u}});
+	DUCT_ASSERTE(table.select(filter, selection) != 0);
+	table.remove(selection);
+	for (auto it = table.begin(); it != table.end(); ++it) {
+		DUCT_ASSERTE(it.get_field(1).data.u16 < 50);
+	}
+	DUCT_ASSERTE(table.erase(table.begin(), table.end()) != 0);
+	DUCT_ASSERTE(table.empty());
+	table.push_back(num_columns, values);
+	DUCT_ASSERTE(table.num_records() == 1);
+	DUCT_ASSERTE(table.find(0, values[0]).index == 0);
+	DUCT_ASSERTE(value_equal(shared, count - 1, 0, {static_cast<std::uint32_t>(count - 1)}));
+}
+
+void
+test_sparse(
+	Data::Table::Layout const layout
+) {
+	auto const sparse = Data::ValueFlag::field_sparse;
+	Data::TableSchema schema{
+		{"id", {Data::ValueType::integer, Data::Size::b32}},
+		{"note", {Data::ValueType::string, sparse, Data::Size::b16}},
+		{"score", {Data::ValueType::integer, sparse, Data::Size::b64}},
+		{"value", {Data::ValueType::dynamic, sparse, Data::Size::b8}},
+		{"name", {Data::ValueType::string, Data::Size::b8}}
+	};
+	Data::TableSchema dense_schema{schema};
+	for (auto& column : dense_schema.columns()) {
+		column.type = {column.type.type(), Data::ValueFlag::none, column.type.size()};
+	}
+	dense_schema.update();
+	Data::Table table{schema};
+	Data::Table dense{dense_schema};
+	table.set_layout(layout);
+	dense.set_layout(layout);
+	table.set_index_column(2);
+
+	// Only every 16th record has its sparse fields
+	unsigned const count = 0x1000;
+	char note[32];
+	Data::ValueRef values[5];
+	for (unsigned index = 0; index < count; ++index) {
+		values[0] = {static_cast<std::uint32_t>(index)};
+		if (index % 16 == 0) {
+			signed const size = std::snprintf(note, sizeof(note), "note %u", index);
+			values[1] = {note, static_cast<unsigned>(size)};
+			values[2] = {static_cast<std::uint64_t>(index + 1)};
+			values[3] = {static_cast<std::int32_t>(index)};
+		} else {
+			values[1] = {""};
+			values[2] = {static_cast<std::uint64_t>(0)};
+			values[3] = {};
+		}
+		values[4] = {"name"};
+		table.push_back(5, values);
+		dense.push_back(5, values);
+	}
+	DUCT_ASSERTE(table.record_stride() == 0);
+	for (unsigned index = 0; index < count; index += 7) {
+		DUCT_ASSERTE(value_equal(table, index, 0, {static_cast<std::uint32_t>(index)}));
+		DUCT_ASSERTE(value_equal(table, index, 4, {"name"}));
+		if (index % 16 == 0) {
+			signed const size = std::snprintf(note, sizeof(note), "note %u", index);
+			DUCT_ASSERTE(value_equal(table, index, 1, {note, static_cast<unsigned>(size)}));
+			DUCT_ASSERTE(value_equal(table, index, 2, {static_cast<std::uint64_t>(index + 1)}));
+			DUCT_ASSERTE(value_equal(table, index, 3, {static_cast<std::int32_t>(index)}));
+		} else {
+			DUCT_ASSERTE(value_equal(table, index, 1, {""}));
+			DUCT_ASSERTE(value_equal(table, index, 2, {static_cast<std::uint64_t>(0)}));
+			DUCT_ASSERTE(value_equal(table, index, 3, {}));
+		}
+	}
+
+	// Absent fields take no space
+	table.compact_storage();
+	dense.compact_storage();
+	std::stringstream sparse_stream{};
+	std::stringstream dense_stream{};
+	{
+		auto ser = make_output_serializer(sparse_stream);
+		ser(table);
+	}
+	{
+		auto ser = make_output_serializer(dense_stream);
+		ser(dense);
+	}
+	DUCT_ASSERTE(sparse_stream.str().size() < dense_stream.str().size() * 3 / 4);
+
+	DUCT_ASSERTE(table.find(2, {static_cast<std::uint64_t>(33)}).index == 32);
+	DUCT_ASSERTE(table.aggregate(2).sum.integer_unsigned() == (count / 16) * (count / 2 - 8 + 1));
+	using Compare = Data::Table::Compare;
+	Data::Table::Filter filter{};
+	Data::Table::Selection selection{};
+	filter.terms.push_back({2, Compare::greater, {0u}});
+	DUCT_ASSERTE(table.select(filter, selection) == count / 16);
+
+	// Setting fields inserts and removes them
+	auto it = table.iterator_at(5);
+	it.set_field(2, {static_cast<std::uint64_t>(7)});
+	it.set_field(1, {"inserted"});
+	DUCT_ASSERTE(value_equal(table, 5, 1, {"inserted"}));
+	DUCT_ASSERTE(value_equal(table, 5, 2, {static_cast<std::uint64_t>(7)}));
+	DUCT_ASSERTE(value_equal(table, 5, 3, {}));
+	DUCT_ASSERTE(value_equal(table, 5, 4, {"name"}));
+	it = table.iterator_at(16);
+	it.set_field(1, {""});
+	it.set_field(3, {"dynamic"});
+	DUCT_ASSERTE(value_equal(table, 16, 1, {""}));
+	DUCT_ASSERTE(value_equal(table, 16, 2, {static_cast<std::uint64_t>(17)}));
+	DUCT_ASSERTE(value_equal(table, 16, 3, {"dynamic"}));
+	DUCT_ASSERTE(value_equal(table, 17, 0, {static_cast<std::uint32_t>(17)}));
+	DUCT_ASSERTE(table.find(2, {static_cast<std::uint64_t>(7)}).index == 5);
+
+	Data::Table copy{};
+	round_trip(table, copy);
+	DUCT_ASSERTE(value_equal(copy, 5, 1, {"inserted"}));
+	DUCT_ASSERTE(value_equal(copy, 16, 3, {"dynamic"}));
+	DUCT_ASSERTE(value_equal(copy, count - 16, 2, {static_cast<std::uint64_t>(count - 15)}));
+
+	// Sparse storage is a column property
+	auto& columns = dense_schema.columns();
+	for (unsigned index = 0; index < columns.size(); ++index) {
+		columns[index].index = index;
+	}
+	dense_schema.update();
+	DUCT_ASSERTE(table.configure(dense_schema));
+	DUCT_ASSERTE(value_equal(table, 5, 1, {"inserted"}));
+	DUCT_ASSERTE(value_equal(table, 6, 2, {static_cast<std::uint64_t>(0)}));
+	DUCT_ASSERTE(value_equal(table, 16, 3, {"dynamic"}));
+	columns[0].type = {Data::ValueType::integer, sparse, Data::Size::b32};
+	dense_schema.update();
+	DUCT_ASSERTE(table.configure(dense_schema));
+	DUCT_ASSERTE(value_equal(table, 0, 0, {static_cast<std::uint32_t>(0)}));
+	DUCT_ASSERTE(value_equal(table, 16, 3, {"dynamic"}));
+	DUCT_ASSERTE(value_equal(table, count - 1, 0, {static_cast<std::uint32_t>(count - 1)}));
+	DUCT_ASSERTE(value_equal(table, count - 1, 4, {"name"}));
+}
+
+void
+test_compact_headers(
+	Data::Table::Layout const layout
+) {
+	Data::TableSchema const schema{
+		{"id", {Data::ValueType::integer, Data::Size::b32}},
+		{"name", {Data::ValueType::string, Data::Size::b16}},
+		{"tag", {Data::ValueType::string, Data::Size::b8}}
+	};
+	Data::Table table{schema};
+	Data::Table wide{schema};
+	table.set_layout(layout);
+	wide.set_layout(layout);
+	DUCT_ASSERTE(table.set_compact_headers(true));
+	DUCT_ASSERTE(!table.set_compact_headers(true));
+	DUCT_ASSERTE(table.compact_headers() && !wide.compact_headers());
+
+	unsigned const count = 0x1000;
+	char name[16];
+	Data::ValueRef values[3];
+	for (unsigned index = 0; index < count; ++index) {
+		signed const size = std::snprintf(name, sizeof(name), "n%u", index);
+		values[0] = {static_cast<std::uint32_t>(index)};
+		values[1] = {name, static_cast<unsigned>(size)};
+		values[2] = {"t"};
+		table.push_back(3, values);
+		wide.push_back(3, values);
+	}
+	std::stringstream compact_stream{};
+	std::stringstream wide_stream{};
+	{
+		auto ser = make_output_serializer(compact_stream);
+		ser(table);
+	}
+	{
+		auto ser = make_output_serializer(wide_stream);
+		ser(wide);
+	}
+	DUCT_ASSERTE(compact_stream.str().size() + count * 3 <= wide_stream.str().size());
+
+	// Headers grow and shrink with their records
+	String const str(0x200, 'L');
+	auto it = table.iterator_at(10);
+	it.set_field(1, {str});
+	it = table.iterator_at(11);
+	it.set_field(2, {"tag"});
+	DUCT_ASSERTE(value_equal(table, 10, 1, {str}));
+	DUCT_ASSERTE(value_equal(table, 10, 2, {"t"}));
+	DUCT_ASSERTE(value_equal(table, 11, 2, {"tag"}));
+	DUCT_ASSERTE(value_equal(table, 12, 0, {static_cast<std::uint32_t>(12)}));
+	it = table.iterator_at(10);
+	it.set_field(1, {"short"});
+	table.compact_storage();
+	DUCT_ASSERTE(value_equal(table, 10, 1, {"short"}));
+	DUCT_ASSERTE(value_equal(table, 10, 2, {"t"}));
+	DUCT_ASSERTE(value_equal(table, 11, 1, {"n11"}));
+	DUCT_ASSERTE(value_equal(table, 11, 2, {"tag"}));
+	values[0] = {static_cast<std::uint32_t>(count)};
+	values[1] = {str};
+	it = table.iterator_at(20);
+	table.insert(it, 3, values);
+	DUCT_ASSERTE(value_equal(table, 20, 1, {str}));
+	DUCT_ASSERTE(value_equal(table, 21, 1, {"n20"}));
+	DUCT_ASSERTE(table.find(0, {static_cast<std::uint32_t>(count - 1)}).index == count);
+
+	Data::Table copy{};
+	round_trip(table, copy);
+	DUCT_ASSERTE(copy.compact_headers());
+	DUCT_ASSERTE(copy.num_records() == count + 1);
+	DUCT_ASSERTE(value_equal(copy, 20, 1, {str}));
+	DUCT_ASSERTE(value_equal(copy, count, 1, {"n4095"}));
+
+	DUCT_ASSERTE(copy.set_compact_headers(false));
+	DUCT_ASSERTE(value_equal(copy, 10, 1, {"short"}));
+	DUCT_ASSERTE(value_equal(copy, 20, 1, {str}));
+	DUCT_ASSERTE(value_equal(copy, count, 0, {static_cast<std::uint32_t>(count - 1)}));
+}
+
+void
+test_cursor(
+	Data::Table::Layout const layout
+) {
+	bool const columnar = layout == Data::Table::Layout::columnar;
+	Data::TableSchema schema{
+		{"id", {Data::ValueType::integer, Data::Size::b32}},
+		columnar
+		? Data::TableSchema::Column{"n", {Data::ValueType::integer, Data::Size::b16}}
+		: Data::TableSchema::Column{"n", {Data::ValueType::string, Data::Size::b8}},
+		{"x", {Data::ValueType::decimal, Data::Size::b64}},
+		columnar
+		? Data::TableSchema::Column{"tag", {Data::ValueType::integer, Data::Size::b8}}
+		: Data::TableSchema::Column{"tag", {
+			Data::ValueType::string,
+			Data::ValueFlag::string_dictionary,
+			Data::Size::b8
+		}}
+	};
+	Data::Table table{schema};
+	table.set_layout(layout);
+	DUCT_ASSERTE(!table.cursor({true, true}).valid());
+
+	unsigned const count = 0x800;
+	char name[16];
+	Data::ValueRef values[4];
+	for (unsigned index = 0; index < count; ++index) {
+		signed const size = std::snprintf(name, sizeof(name), "n%u", index);
+		values[0] = {static_cast<std::uint32_t>(index)};
+		if (columnar) {
+			values[1] = {static_cast<std::uint16_t>(index)};
+			values[3] = {static_cast<std::uint8_t>(index % 3)};
+		} else {
+			values[1] = {name, static_cast<unsigned>(size)};
+			values[3] = {index % 3 ? "odd" : "even"};
+		}
+		values[2] = {index * 0.5};
+		table.push_back(4, values);
+	}
+
+	// Masked columns match get_field(); others are null
+	auto check = [&table](aux::vector<bool> const& mask) {
+		unsigned num_records = 0;
+		for (auto cursor = table.cursor(mask); cursor.valid(); ++cursor) {
+			DUCT_ASSERTE(cursor.values.size() == table.num_columns());
+			for (unsigned index = 0; index < table.num_columns(); ++index) {
+				auto const& value = cursor.values[index];
+				if (index < mask.size() && mask[index]) {
+					DUCT_ASSERTE(value == cursor.it.get_field(index));
+				} else {
+					DUCT_ASSERTE(value.type.type() == Data::ValueType::null);
+				}
+			}
+			++num_records;
+		}
+		DUCT_ASSERTE(num_records == table.num_records());
+	};
+	check({true, true, true, true});
+	check({false, true});
+	check({true, false, false, true});
+	check({});
+
+	// Appended columns of older chunks read as initial values
+	auto& columns = schema.columns();
+	for (unsigned index = 0; index < columns.size(); ++index) {
+		columns[index].index = index;
+	}
+	columns.push_back({"y", {Data::ValueType::integer, Data::Size::b16}});
+	schema.update();
+	DUCT_ASSERTE(table.configure(schema));
+	values[0] = {static_cast<std::uint32_t>(count)};
+	values[3] = columnar ? Data::ValueRef{static_cast<std::uint8_t>(1)} : Data::ValueRef{"odd"};
+	table.push_back(4, values);
+	auto it = table.iterator_at(count);
+	it.set_field(4, {static_cast<std::uint16_t>(9)});
+	check({true, true, true, true, true});
+	check({false, false, true, false, true});
+	auto cursor = table.cursor({true, false, false, false, true});
+	DUCT_ASSERTE(cursor.values[4] == Data::ValueRef(static_cast<std::uint16_t>(0)));
+	cursor.it = table.iterator_at(count);
+	cursor.read();
+	DUCT_ASSERTE(cursor.values[0] == Data::ValueRef(static_cast<std::uint32_t>(count)));
+	DUCT_ASSERTE(cursor.values[4] == Data::ValueRef(static_cast<std::uint16_t>(9)));
+}
+
+void
+test_zones(
+	Data::Table::Layout const layout
+) {
+	bool const columnar = layout == Data::Table::Layout::columnar;
+	Data::TableSchema schema{
+		{"t", {Data::ValueType::integer, Data::Size::b64}},
+		{"v", {Data::ValueType::integer, Data::ValueFlag::integer_signed, Data::Size::b32}},
+		{"x", {Data::ValueType::decimal, Data::Size::b64}}
+	};
+	if (!columnar) {
+		schema.columns().push_back({"s", {Data::ValueType::string, Data::Size::b8}});
+		schema.update();
+	}
+	unsigned const num_columns = columnar ? 3 : 4;
+	Data::Table table{schema};
+	table.set_layout(layout);
+
+	// Append-ordered times; other columns cycle within each chunk
+	unsigned const count = 0x4000;
+	String const name(8, 'n');
+	Data::ValueRef values[4];
+	for (unsigned index = 0; index < count; ++index) {
+		values[0] = {static_cast<std::uint64_t>(1000 + index)};
+		values[1] = {static_cast<std::int32_t>(index % 200) - 100};
+		values[2] = {index % 7 == 0 ? -0.0 : index * 0.25};
+		values[3] = {name.data(), static_cast<unsigned>(index % 5 + 4)};
+		table.push_back(num_columns, values);
+	}
+
+	// Selections match a scan of every record
+	using Compare = Data::Table::Compare;
+	Data::Table::Filter filter{};
+	Data::Table::Selection selection{};
+	auto check = [&table, &filter, &selection](
+		unsigned const column,
+		Compare const compare,
+		Data::ValueRef const& value
+	) {
+		filter.terms.assign(1, {column, compare, value});
+		unsigned const count = table.select(filter, selection);
+		unsigned expected = 0;
+		for (auto it = table.begin(); it != table.end(); ++it) {
+			auto field = it.get_field(column);
+			signed order;
+			if (field.type.type() == Data::ValueType::string) {
+				order = field.size < value.size ? -1 : field.size > value.size ? 1 : 0;
+				if (order == 0) {
+					order = std::memcmp(field.data.string, value.data.string, field.size);
+				}
+			} else if (field.type.type() == Data::ValueType::decimal) {
+				order = field.decimal() < value.decimal() ? -1 : field.decimal() > value.decimal() ? 1 : 0;
+			} else if (column == 1) {
+				order = field.integer_signed() < value.integer_signed() ? -1 : field.integer_signed() > value.integer_signed() ? 1 : 0;
+			} else {
+				order = field.integer_unsigned() < value.integer_unsigned() ? -1 : field.integer_unsigned() > value.integer_unsigned() ? 1 : 0;
+			}
+			bool match = false;
+			switch (compare) {
+			case Compare::equal: match = order == 0; break;
+			case Compare::not_equal: match = order != 0; break;
+			case Compare::less: match = order < 0; break;
+			case Compare::less_equal: match = order <= 0; break;
+			case Compare::greater: match = order > 0; break;
+			case Compare::greater_equal: match = order >= 0; break;
+			}
+			DUCT_ASSERTE(selection.test(it.index) == match);
+			expected += match;
+		}
+		DUCT_ASSERTE(count == expected);
+		return count;
+	};
+	auto check_all = [&check, columnar, &name]() {
+		check(0, Compare::less, {static_cast<std::uint64_t>(1100)});
+		check(0, Compare::greater_equal, {static_cast<std::uint64_t>(1000 + count - 10)});
+		check(0, Compare::equal, {static_cast<std::uint64_t>(1000 + count / 2)});
+		check(0, Compare::not_equal, {static_cast<std::uint64_t>(5)});
+		check(0, Compare::less_equal, {static_cast<std::uint64_t>(999)});
+		check(0, Compare::greater, {static_cast<std::uint64_t>(1000 + count / 3)});
+		check(1, Compare::equal, {static_cast<std::int32_t>(-100)});
+		check(1, Compare::greater, {static_cast<std::int32_t>(50)});
+		check(1, Compare::less, {static_cast<std::int32_t>(-500)});
+		check(2, Compare::equal, {0.0});
+		check(2, Compare::less_equal, {-0.0});
+		check(2, Compare::greater, {count * 0.2});
+		check(2, Compare::not_equal, {0.0});
+		if (!columnar) {
+			check(3, Compare::equal, {name.data(), 6u});
+			check(3, Compare::equal, {name.data(), 2u});
+			check(3, Compare::less, {name.data(), 6u});
+		}
+	};
+	DUCT_ASSERTE(check(0, Compare::less, {static_cast<std::uint64_t>(1100)}) == 100);
+	DUCT_ASSERTE(check(0, Compare::greater_equal, {static_cast<std::uint64_t>(1000 + count - 10)}) == 10);
+	check_all();
+
+	// Modified values widen zones
+	auto it = table.iterator_at(count / 2);
+	it.set_field(0, {static_cast<std::uint64_t>(5)});
+	it.set_field(1, {static_cast<std::int32_t>(-1000)});
+	if (!columnar) {
+		it.set_field(3, {name.data(), 2u});
+	}
+	it = table.iterator_at(count / 4);
+	values[0] = {static_cast<std::uint64_t>(1)};
+	table.insert(it, num_columns, values);
+	DUCT_ASSERTE(check(0, Compare::less, {static_cast<std::uint64_t>(10)}) == 2);
+	DUCT_ASSERTE(check(1, Compare::equal, {static_cast<std::int32_t>(-1000)}) == 1);
+	check_all();
+	it = table.iterator_at(count / 4);
+	table.remove(it);
+
+	// Zones are rebuilt by compaction and persisted
+	table.compact_storage();
+	check_all();
+	Data::Table copy{};
+	round_trip(table, copy);
+	table.assign(copy);
+	DUCT_ASSERTE(check(0, Compare::equal, {static_cast<std::uint64_t>(5)}) == 1);
+	check_all();
+	table.clear();
+	table.push_back(num_columns, values);
+	DUCT_ASSERTE(check(0, Compare::equal, {static_cast<std::uint64_t>(1)}) == 1);
+}
+
+void
+test_blooms(
+	Data::Table::Layout const layout
+) {
+	bool const columnar = layout == Data::Table::Layout::columnar;
+	Data::TableSchema schema{
+		{"id", {Data::ValueType::object_id}},
+		{"n", {Data::ValueType::integer, Data::Size::b32}}
+	};
+	if (!columnar) {
+		schema.columns().push_back({"host", {Data::ValueType::string, Data::Size::b8}});
+		schema.update();
+	}
+	unsigned const num_columns = columnar ? 2 : 3;
+	Data::Table table{schema};
+	table.set_layout(layout);
+	DUCT_ASSERTE(table.set_bloom_column(0, true));
+	DUCT_ASSERTE(!table.set_bloom_column(0, true));
+	DUCT_ASSERTE(!table.set_bloom_column(1, true));
+	DUCT_ASSERTE(!table.set_bloom_column(num_columns, true));
+	DUCT_ASSERTE(columnar || table.set_bloom_column(2, true));
+	DUCT_ASSERTE(table.bloom_column(0) && !table.bloom_column(1));
+
+	// Unordered IDs, hosts repeating within chunks
+	unsigned const count = 0x4000;
+	char host[16];
+	Data::ValueRef values[3];
+	auto make_record = [&values, &host](unsigned const index) {
+		values[0] = {Object::ID{(index * 0x9E3779B1u) | 1u}};
+		values[1] = {static_cast<std::uint32_t>(index)};
+		unsigned const size = std::snprintf(host, sizeof(host), "host%u", index / 0x100);
+		values[2] = {host, size};
+	};
+	for (unsigned index = 0; index < count; ++index) {
+		make_record(index);
+		table.push_back(num_columns, values);
+	}
+
+	// Selections match a scan of every record
+	using Compare = Data::Table::Compare;
+	Data::Table::Filter filter{};
+	Data::Table::Selection selection{};
+	auto check = [&filter, &selection](
+		Data::Table& table,
+		unsigned const column,
+		Data::ValueRef const& value
+	) {
+		unsigned expected = 0;
+		filter.terms.assign(1, {column, Compare::equal, value});
+		unsigned const count = table.select(filter, selection);
+		for (auto it = table.begin(); it != table.end(); ++it) {
+			bool const match = it.get_field(column) == value;
+			DUCT_ASSERTE(selection.test(it.index) == match);
+			expected += match;
+		}
+		DUCT_ASSERTE(count == expected);
+		filter.terms.assign(1, {column, Compare::not_equal, value});
+		DUCT_ASSERTE(table.select(filter, selection) == table.num_records() - expected);
+		return count;
+	};
+	auto check_all = [&check, &make_record, &values, columnar](Data::Table& table) {
+		for (unsigned index = 0; index < count; index += 0x3FF) {
+			make_record(index);
+			DUCT_ASSERTE(check(table, 0, values[0]) == 1);
+			if (!columnar) {
+				DUCT_ASSERTE(check(table, 2, values[2]) == 0x100);
+			}
+		}
+		DUCT_ASSERTE(check(table, 0, {Object::ID{2}}) == 0);
+		DUCT_ASSERTE(check(table, 0, {Object::ID{0}}) == 0);
+		if (!columnar) {
+			DUCT_ASSERTE(check(table, 2, {"absent"}) == 0);
+		}
+	};
+	check_all(table);
+	table.compact_storage();
+	check_all(table);
+
+	// Added and modified values are taken by filters
+	auto it = table.iterator_at(count / 2);
+	it.set_field(0, {Object::ID{2}});
+	values[0] = {Object::ID{4}};
+	it = table.iterator_at(count / 3);
+	table.insert(it, num_columns, values);
+	for (unsigned index = 0; index < count; ++index) {
+		values[0] = {Object::ID{6 + 2 * index}};
+		table.push_back(num_columns, values);
+	}
+	DUCT_ASSERTE(check(table, 0, {Object::ID{2}}) == 1);
+	DUCT_ASSERTE(check(table, 0, {Object::ID{4}}) == 1);
+	DUCT_ASSERTE(check(table, 0, {Object::ID{6 + count}}) == 1);
+
+	// Filters are read with chunks and dropped with the setting
+	Data::Table copy{};
+	round_trip(table, copy);
+	DUCT_ASSERTE(!copy.bloom_column(0));
+	DUCT_ASSERTE(check(copy, 0, {Object::ID{2}}) == 1);
+	DUCT_ASSERTE(check(copy, 0, {Object::ID{6 + count}}) == 1);
+	DUCT_ASSERTE(table.set_bloom_column(0, false));
+	DUCT_ASSERTE(!table.bloom_column(0));
+	DUCT_ASSERTE(check(table, 0, {Object::ID{4}}) == 1);
+	table.remove(it);
+	DUCT_ASSERTE(check(table, 0, {Object::ID{4}}) == 0);
+}
+
 signed
 main() {
+	test_layout(Data::Table::Layout::sequential);
+	test_layout(Data::Table::Layout::indexed);
+	test_stride();
+	test_columnar();
+	test_aggregate(Data::Table::Layout::sequential);
+	test_aggregate(Data::Table::Layout::indexed);
+	test_select(Data::Table::Layout::sequential);
+	test_select(Data::Table::Layout::indexed);
+	test_select(Data::Table::Layout::columnar);
+	test_append(Data::Table::Layout::sequential);
+	test_append(Data::Table::Layout::indexed);
+	test_append(Data::Table::Layout::columnar);
+	test_allocator();
+	test_compact(Data::Table::Layout::sequential);
+	test_compact(Data::Table::Layout::indexed);
+	test_chunk_tree(Data::Table::Layout::sequential);
+	test_chunk_tree(Data::Table::Layout::indexed);
+	test_share(Data::Table::Layout::sequential);
+	test_share(Data::Table::Layout::indexed);
+	test_share(Data::Table::Layout::columnar);
+	test_migrate(Data::Table::Layout::sequential);
+	test_migrate(Data::Table::Layout::indexed);
+	test_instant_columns(Data::Table::Layout::sequential);
+	test_instant_columns(Data::Table::Layout::indexed);
+	test_instant_columns(Data::Table::Layout::columnar);
+	test_index(Data::Table::Layout::sequential);
+	test_index(Data::Table::Layout::indexed);
+	test_index(Data::Table::Layout::columnar);
+	test_ordered_index(Data::Table::Layout::sequential);
+	test_ordered_index(Data::Table::Layout::indexed);
+	test_ordered_index(Data::Table::Layout::columnar);
+	test_dictionary(Data::Table::Layout::sequential);
+	test_dictionary(Data::Table::Layout::indexed);
+	test_dictionary(Data::Table::Layout::columnar);
+	test_codecs(Data::Table::Layout::sequential);
+	test_codecs(Data::Table::Layout::indexed);
+	test_codecs(Data::Table::Layout::columnar);
+	test_mapped(Data::Table::Layout::sequential);
+	test_mapped(Data::Table::Layout::indexed);
+	test_mapped(Data::Table::Layout::columnar);
+	test_sort(Data::Table::Layout::sequential);
+	test_sort(Data::Table::Layout::indexed);
+	test_sort(Data::Table::Layout::columnar);
+	test_remove(Data::Table::Layout::sequential);
+	test_remove(Data::Table::Layout::indexed);
+	test_remove(Data::Table::Layout::columnar);
+	test_sparse(Data::Table::Layout::sequential);
+	test_sparse(Data::Table::Layout::indexed);
+	test_sparse(Data::Table::Layout::columnar);
+	test_compact_headers(Data::Table::Layout::sequential);
+	test_compact_headers(Data::Table::Layout::indexed);
+	test_cursor(Data::Table::Layout::sequential);
+	test_cursor(Data::Table::Layout::indexed);
+	test_cursor(Data::Table::Layout::columnar);
+	test_zones(Data::Table::Layout::sequential);
+	test_zones(Data::Table::Layout::indexed);
+	test_zones(Data::Table::Layout::columnar);
+	test_blooms(Data::Table::Layout::sequential);
+	test_blooms(Data::Table::Layout::indexed);
+	test_blooms(Data::Table::Layout::columnar);
+
 	Data::Table table{};
 
 	{
@@ -76,6 +2092,45 @@ main() {
 		DUCT_ASSERTE(value_equal(table, 0, 0, {str}));
 	}
 
+	{
+		Data::TableSchema const schema{
+			{"x", {Data::ValueType::integer, Data::Size::b32}}
+		};
+		Data::Table seq{schema};
+		Data::ValueRef values[1];
+		unsigned const count = 0x1000;
+		for (unsigned index = 0; index < count; ++index) {
+			values[0] = {static_cast<std::uint32_t>(index)};
+			seq.push_back(1, values);
+		}
+		for (unsigned index = 0; index < count; index += 37) {
+			DUCT_ASSERTE(value_equal(seq, index, 0, {static_cast<std::uint32_t>(index)}));
+		}
+		DUCT_ASSERTE(seq.iterator_at(count) == seq.end());
+
+		// Split a full chunk at the head
+		auto it = seq.iterator_at(10);
+		values[0] = {static_cast<std::uint32_t>(~0u)};
+		it.insert(1, values);
+		DUCT_ASSERTE(value_equal(seq, 9, 0, {static_cast<std::uint32_t>(9)}));
+		DUCT_ASSERTE(value_equal(seq, 10, 0, values[0]));
+		DUCT_ASSERTE(value_equal(seq, 11, 0, {static_cast<std::uint32_t>(10)}));
+		it = seq.iterator_at(10);
+		it.remove();
+
+		it = seq.begin();
+		for (unsigned index = 0; it.can_advance(); ++it, ++index) {
+			DUCT_ASSERTE(it.index == index);
+			DUCT_ASSERTE(it.get_field(0) == Data::ValueRef{static_cast<std::uint32_t>(index)});
+		}
+		it = seq.begin();
+		it += 100;
+		it += 1;
+		DUCT_ASSERTE(it.get_field(0) == Data::ValueRef{static_cast<std::uint32_t>(101)});
+		it += count;
+		DUCT_ASSERTE(it == seq.end());
+	}
+
 	{
 		Data::TableSchema schema{};
 		DUCT_ASSERTE(table.configure(schema));